@@ -9,6 +9,8 @@ struct Material {
     float shininess;
 }; 
 
+// the light structs are packed for std140, every float fills the last 4 bytes of a vec3,
+// SceneLights in scene_lights.h has the same layout
 struct DirLight {
     vec3 direction;
 	
@@ -19,29 +21,25 @@ struct DirLight {
 
 struct PointLight {
     vec3 position;
-    
     float constant;
-    float linear;
-    float quadratic;
-	
     vec3 ambient;
+    float linear;
     vec3 diffuse;
+    float quadratic;
     vec3 specular;
 };
 
 struct SpotLight {
     vec3 position;
-    vec3 direction;
     float cutOff;
+    vec3 direction;
     float outerCutOff;
-  
+    vec3 ambient;
     float constant;
+    vec3 diffuse;
     float linear;
+    vec3 specular;
     float quadratic;
-  
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;       
 };
 
 #define NR_POINT_LIGHTS 4
@@ -50,10 +48,17 @@ in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoords;
 
-uniform vec3 viewPos;
-uniform DirLight dirLight;
-uniform PointLight pointLights[NR_POINT_LIGHTS];
-uniform SpotLight spotLight;
+// per-frame camera data and the lights, shared by every program, see scene_uniforms.h
+layout (std140) uniform Camera {
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+};
+layout (std140) uniform Lights {
+    DirLight dirLight;
+    PointLight pointLights[NR_POINT_LIGHTS];
+    SpotLight spotLight;
+};
 uniform Material material;
 
 // function prototypes
@@ -65,7 +70,7 @@ void main()
 {    
     // properties
     vec3 norm = normalize(Normal);
-    vec3 viewDir = normalize(viewPos - FragPos);
+    vec3 viewDir = normalize(viewPos.xyz - FragPos);
     
     // == =====================================================
     // Our lighting is set up in 3 phases: directional, point lights and an optional flashlight
@@ -2,19 +2,27 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+// per-instance model matrix, read instead of model when instanced is set
+layout (location = 7) in mat4 aInstanceModel;
 
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoords;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// per-frame camera data shared by every program, see scene_uniforms.h
+layout (std140) uniform Camera {
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+};
+uniform bool instanced;
 
 void main()
 {
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;  
+    mat4 world = instanced ? aInstanceModel : model;
+    FragPos = vec3(world * vec4(aPos, 1.0));
+    Normal = mat3(transpose(inverse(world))) * aNormal;  
     TexCoords = aTexCoords;
     
     gl_Position = projection * view * vec4(FragPos, 1.0);
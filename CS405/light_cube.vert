@@ -4,8 +4,12 @@
 layout (location = 0) in vec3 aPos;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// per-frame camera data shared by every program, see scene_uniforms.h
+layout (std140) uniform Camera {
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+};
 
 void main()
 {
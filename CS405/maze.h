@@ -0,0 +1,464 @@
+#ifndef MAZE_H
+#define MAZE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "random.h"
+
+// Directions a maze cell can be left through
+enum MazeDirection {
+    NORTH,
+    EAST,
+    SOUTH,
+    WEST
+};
+
+// Offsets of the neighbouring cell for each MazeDirection
+const int MAZE_DX[4] = { 0, 1, 0, -1 };
+const int MAZE_DY[4] = { -1, 0, 1, 0 };
+
+// Bit scans and counts over the packed 64-bit words of the maze's bit planes, one instruction
+// where the compiler has an intrinsic for it. v must not be 0 for lowestBit() and highestBit()
+inline int lowestBit(uint64_t v)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, v);
+    return (int)index;
+#elif defined(__GNUC__)
+    return __builtin_ctzll(v);
+#else
+    int n = 0;
+    if (!(v & 0xFFFFFFFFull)) { n += 32; v >>= 32; }
+    if (!(v & 0xFFFFull)) { n += 16; v >>= 16; }
+    if (!(v & 0xFFull)) { n += 8; v >>= 8; }
+    if (!(v & 0xFull)) { n += 4; v >>= 4; }
+    if (!(v & 0x3ull)) { n += 2; v >>= 2; }
+    if (!(v & 0x1ull)) { n += 1; }
+    return n;
+#endif
+}
+
+inline int highestBit(uint64_t v)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanReverse64(&index, v);
+    return (int)index;
+#elif defined(__GNUC__)
+    return 63 - __builtin_clzll(v);
+#else
+    int n = 0;
+    if (v >> 32) { n += 32; v >>= 32; }
+    if (v >> 16) { n += 16; v >>= 16; }
+    if (v >> 8) { n += 8; v >>= 8; }
+    if (v >> 4) { n += 4; v >>= 4; }
+    if (v >> 2) { n += 2; v >>= 2; }
+    if (v >> 1) { n += 1; }
+    return n;
+#endif
+}
+
+inline int popCount(uint64_t v)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    return (int)__popcnt64(v);
+#elif defined(__GNUC__)
+    return __builtin_popcountll(v);
+#else
+    v = v - ((v >> 1) & 0x5555555555555555ull);
+    v = (v & 0x3333333333333333ull) + ((v >> 2) & 0x3333333333333333ull);
+    v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+    return (int)((v * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+// A maze of Width x Height cells whose size is decided at runtime.
+// Only the east and south wall of every cell is stored, one bit each, in two planes of
+// packed 64-bit words (rows are padded to whole words). North and west walls are the
+// south and east walls of the neighbouring cell, the outer border is always a wall.
+// That is 2 bits per cell instead of the 4 chars per cell the old character grid needed,
+// and a whole word of neighbour tests is a single bit operation.
+//
+// The old character grid is still available through IsOpen(): cells live on the odd
+// coordinates of a (2 * Width + 1) x (2 * Height + 1) grid and the even coordinates are
+// the walls between them, so compMap(), Print() and collision walk it like before.
+class Maze
+{
+public:
+    // size in cells
+    int Width;
+    int Height;
+
+    // constructor, the maze starts out with every wall standing
+    Maze(int width = 0, int height = 0)
+    {
+        Resize(width, height);
+    }
+
+    // copies always get their own wall bits, even when the original uses external memory
+    Maze(const Maze& other)
+    {
+        *this = other;
+    }
+
+    Maze& operator=(const Maze& other)
+    {
+        if (this == &other)
+            return *this;
+        setSize(other.Width, other.Height);
+        walls.assign(other.bits, other.bits + 2 * planeWords);
+        bits = walls.empty() ? nullptr : &walls[0];
+        owner.reset();
+        touch();
+        return *this;
+    }
+
+    // changes the size of the maze and puts every wall back
+    void Resize(int width, int height)
+    {
+        setSize(width, height);
+        walls.assign(2 * planeWords, ~0ull);
+        bits = walls.empty() ? nullptr : &walls[0];
+        owner.reset();
+        touch();
+    }
+
+    // uses the 2 * WordsPerRow() * height words at external as the wall planes instead of a
+    // copy of its own, e.g. a memory mapped maze file; owner keeps that memory alive
+    void Wrap(int width, int height, uint64_t* external, std::shared_ptr<void> externalOwner)
+    {
+        setSize(width, height);
+        std::vector<uint64_t>().swap(walls);
+        bits = external;
+        owner = externalOwner;
+        touch();
+    }
+
+    // puts every wall back
+    void Reset()
+    {
+        std::fill(bits, bits + 2 * planeWords, ~0ull);
+        touch();
+    }
+
+    // size of the character grid
+    int GridWidth() const { return 2 * Width + 1; }
+    int GridHeight() const { return 2 * Height + 1; }
+
+    // number of 64-bit words in one row of a wall plane
+    int WordsPerRow() const { return wordsPerRow; }
+
+    // bytes used by the wall planes
+    size_t MemoryBytes() const { return 2 * planeWords * sizeof(uint64_t); }
+
+    // both wall planes, east plane first, MemoryBytes() long
+    const uint64_t* WallData() const { return bits; }
+
+    // packed rows of the wall planes, bit x of the row is set if cell (x,y) has a wall
+    // on its east (south) side. Padding bits past Width are always set.
+    const uint64_t* EastWalls(int y) const { return bits + (size_t)y * wordsPerRow; }
+    const uint64_t* SouthWalls(int y) const { return bits + planeWords + (size_t)y * wordsPerRow; }
+
+    // converts the cell pair (x,y) into a single-dimensional index, y * Width + x
+    int XYToIndex(int x, int y) const
+    {
+        return y * Width + x;
+    }
+
+    // returns true if the cell (x,y) is inside the maze
+    bool IsInBounds(int x, int y) const
+    {
+        if (x < 0 || x >= Width) return false;
+        if (y < 0 || y >= Height) return false;
+        return true;
+    }
+
+    // returns true if the grid position (x,y) is inside the character grid
+    bool IsInGrid(int x, int y) const
+    {
+        if (x < 0 || x >= GridWidth()) return false;
+        if (y < 0 || y >= GridHeight()) return false;
+        return true;
+    }
+
+    // returns true if the grid position (x,y) is a passage, out of grid positions are walls
+    bool IsOpen(int x, int y) const
+    {
+        if (!IsInGrid(x, y))
+            return false;
+        bool cellX = (x & 1) != 0;
+        bool cellY = (y & 1) != 0;
+        if (cellX && cellY)
+            return true;
+        if (cellY)
+            return x > 0 && x < GridWidth() - 1 && !eastWall(x / 2 - 1, y / 2);
+        if (cellX)
+            return y > 0 && y < GridHeight() - 1 && !southWall(x / 2, y / 2 - 1);
+        return false;
+    }
+
+    // returns true if there is a wall between cell (x,y) and its neighbour in direction dir
+    bool HasWall(int x, int y, int dir) const
+    {
+        switch (dir)
+        {
+        case NORTH: return y == 0 || southWall(x, y - 1);
+        case EAST: return eastWall(x, y);
+        case SOUTH: return southWall(x, y);
+        default: return x == 0 || eastWall(x - 1, y);
+        }
+    }
+
+    // returns the open directions of cell (x,y) as a mask, bit dir is set if the cell can be left that way
+    int OpenDirections(int x, int y) const
+    {
+        int mask = 0;
+        for (int dir = 0; dir < 4; ++dir)
+        {
+            if (!HasWall(x, y, dir))
+                mask |= 1 << dir;
+        }
+        return mask;
+    }
+
+    // changes a wall of a finished maze, e.g. for shifting walls while the level is played.
+    // Unlike Carve() and AddWall() this starts a new Revision() so caches built from the maze
+    // notice the change; the outer border can't be opened.
+    void SetWall(int x, int y, int dir, bool wall)
+    {
+        if (!IsInBounds(x, y) || !IsInBounds(x + MAZE_DX[dir], y + MAZE_DY[dir]))
+            return;
+        if (wall)
+            AddWall(x, y, dir);
+        else
+            Carve(x, y, dir);
+        touch();
+    }
+
+    // number that changes whenever the walls do through anything but Carve() and AddWall(),
+    // which generators call on their own threads while the maze isn't in use yet. It is unique
+    // across mazes, so a cache only needs to remember the revision it was built from.
+    uint64_t Revision() const { return revision; }
+
+    // knocks down the wall between cell (x,y) and its neighbour in direction dir
+    void Carve(int x, int y, int dir)
+    {
+        switch (dir)
+        {
+        case NORTH: clearBit(planeWords, x, y - 1); break;
+        case EAST: clearBit(0, x, y); break;
+        case SOUTH: clearBit(planeWords, x, y); break;
+        default: clearBit(0, x - 1, y); break;
+        }
+    }
+
+    // puts the wall between cell (x,y) and its neighbour in direction dir back
+    void AddWall(int x, int y, int dir)
+    {
+        switch (dir)
+        {
+        case NORTH: setBit(planeWords, x, y - 1); break;
+        case EAST: setBit(0, x, y); break;
+        case SOUTH: setBit(planeWords, x, y); break;
+        default: setBit(0, x - 1, y); break;
+        }
+    }
+
+    // knocks down every wall inside the maze, only the outer border stays
+    void OpenAll()
+    {
+        for (int y = 0; y < Height; ++y)
+        {
+            for (int x = 0; x < Width; ++x)
+            {
+                if (x + 1 < Width) Carve(x, y, EAST);
+                if (y + 1 < Height) Carve(x, y, SOUTH);
+            }
+        }
+        touch();
+    }
+
+    // number of dead ends, cells with exactly one way out
+    size_t CountDeadEnds() const
+    {
+        size_t count = 0;
+        for (int y = 0; y < Height; ++y)
+        {
+            for (int x = 0; x < Width; ++x)
+            {
+                int open = OpenDirections(x, y);
+                if (open != 0 && (open & (open - 1)) == 0)
+                    count++;
+            }
+        }
+        return count;
+    }
+
+    // carves a perfect maze with a randomized depth first search starting at cell (x,y),
+    // the same seed always carves the same maze. Returns the bytes of scratch memory used.
+    size_t Generate(int x, int y, uint64_t seed)
+    {
+        Random random(seed);
+        touch();
+        return GenerateRegion(0, 0, Width, Height, x, y, random);
+    }
+
+    // carves a perfect maze inside the cells x0 <= x < x1, y0 <= y < y1 with a randomized depth
+    // first search starting at cell (x,y), no wall on the border of the region is touched.
+    // The search keeps its own stack on the heap instead of recursing, one byte per cell on
+    // the current path holding the direction back to the previous cell, plus one bit per
+    // cell of the region to remember which cells were visited.
+    // The step itself has no branch on the direction: the unvisited neighbours are a 4 bit
+    // mask (the rows above and below the region are padding marked visited), the random pick
+    // is the n-th set bit of the mask from a table, and the wall carved is addressed from the
+    // direction with arithmetic. The directions are picked in the same order as a loop over
+    // them would, so a seed carves the same maze.
+    // Regions that start and end on a multiple of 64 columns only write their own words, so
+    // they can be carved by different threads at the same time, each with its own Random stream.
+    // Returns the bytes of scratch memory used.
+    size_t GenerateRegion(int x0, int y0, int x1, int y1, int x, int y, Random& random)
+    {
+        // the set bits of each 4 bit mask in increasing order, 2 bits each
+        static const uint8_t nthDirection[16] = {
+            0x00, 0x00, 0x01, 0x04, 0x02, 0x08, 0x09, 0x24, 0x03, 0x0C, 0x0D, 0x34, 0x0E, 0x38, 0x39, 0xE4
+        };
+        int width = x1 - x0, height = y1 - y0;
+        int regionWords = (width + 63) / 64;
+        std::vector<unsigned char> stack;
+        std::vector<uint64_t> visited((size_t)regionWords * (height + 2), 0);
+        std::fill(visited.begin(), visited.begin() + regionWords, ~0ull);
+        std::fill(visited.end() - regionWords, visited.end(), ~0ull);
+        uint64_t* rows = &visited[regionWords];
+        auto visitedAt = [&](int cx, int cy) -> uint64_t {
+            return (rows[(ptrdiff_t)cy * regionWords + (cx >> 6)] >> (cx & 63)) & 1;
+        };
+
+        // region relative cell
+        int cx = x - x0, cy = y - y0;
+        rows[(size_t)cy * regionWords + (cx >> 6)] |= 1ull << (cx & 63);
+        while (true)
+        {
+            int open = (int)((visitedAt(cx, cy - 1) ^ 1)
+                | ((cx + 1 < width ? visitedAt(cx + 1, cy) ^ 1 : 0) << 1)
+                | ((visitedAt(cx, cy + 1) ^ 1) << 2)
+                | ((cx > 0 ? visitedAt(cx - 1, cy) ^ 1 : 0) << 3));
+            if (open != 0)
+            {
+                // knock down the wall between my current position and a random unvisited neighbour
+                // and move on, the wall is the east (odd dir) or south wall of this cell or the
+                // west or north neighbour
+                int dir = (nthDirection[open] >> (2 * random.NextInt(popCount((uint64_t)open)))) & 3;
+                int wx = x0 + cx - (dir == WEST), wy = y0 + cy - (dir == NORTH);
+                bits[((dir & 1) ? 0 : planeWords) + bitWord(wx, wy)] &= ~(1ull << (wx & 63));
+                cx += MAZE_DX[dir];
+                cy += MAZE_DY[dir];
+                rows[(size_t)cy * regionWords + (cx >> 6)] |= 1ull << (cx & 63);
+                stack.push_back((unsigned char)((dir + 2) & 3));
+                continue;
+            }
+            // dead end, walk back to the previous cell
+            if (stack.empty())
+                break;
+            int back = stack.back();
+            stack.pop_back();
+            cx += MAZE_DX[back];
+            cy += MAZE_DY[back];
+        }
+        return stack.capacity() + visited.size() * sizeof(uint64_t);
+    }
+
+    // writes the maze as characters, one grid row per line
+    void Print(std::ostream& out) const
+    {
+        std::string line(GridWidth() + 1, '#');
+        line[GridWidth()] = '\n';
+        for (int y = 0; y < GridHeight(); ++y)
+        {
+            for (int x = 0; x < GridWidth(); ++x)
+                line[x] = IsOpen(x, y) ? ' ' : '#';
+            out.write(line.data(), line.size());
+        }
+        out.flush();
+    }
+
+private:
+    int wordsPerRow;
+    size_t planeWords;
+    // east wall plane followed by the south wall plane, bits points either into walls or
+    // into external memory that owner keeps alive
+    std::vector<uint64_t> walls;
+    uint64_t* bits = nullptr;
+    std::shared_ptr<void> owner;
+    uint64_t revision = 0;
+
+    void touch()
+    {
+        static std::atomic<uint64_t> revisions(0);
+        revision = ++revisions;
+    }
+
+    void setSize(int width, int height)
+    {
+        Width = width;
+        Height = height;
+        wordsPerRow = (Width + 63) / 64;
+        planeWords = (size_t)wordsPerRow * Height;
+    }
+
+    size_t bitWord(int x, int y) const
+    {
+        return (size_t)y * wordsPerRow + (x >> 6);
+    }
+
+    bool eastWall(int x, int y) const
+    {
+        return (bits[bitWord(x, y)] >> (x & 63)) & 1;
+    }
+
+    bool southWall(int x, int y) const
+    {
+        return (bits[planeWords + bitWord(x, y)] >> (x & 63)) & 1;
+    }
+
+    void clearBit(size_t plane, int x, int y)
+    {
+        bits[plane + bitWord(x, y)] &= ~(1ull << (x & 63));
+    }
+
+    void setBit(size_t plane, int x, int y)
+    {
+        bits[plane + bitWord(x, y)] |= 1ull << (x & 63);
+    }
+};
+
+// Interface of the maze generation algorithms, see maze_generators.h.
+// Every algorithm carves a perfect maze into the same packed Maze the rest of the game reads.
+class MazeGenerator
+{
+public:
+    virtual ~MazeGenerator() {}
+
+    // name of the algorithm
+    virtual const char* Name() const = 0;
+
+    // carves a perfect maze into maze, the same seed always gives the same maze
+    virtual void Generate(Maze& maze, uint64_t seed) = 0;
+
+    // peak bytes of scratch memory the last Generate() needed on top of the maze itself
+    size_t ScratchBytes() const { return scratchBytes; }
+
+protected:
+    size_t scratchBytes = 0;
+};
+#endif
@@ -0,0 +1,252 @@
+#ifndef MAZE_BATCH_H
+#define MAZE_BATCH_H
+
+#include "maze.h"
+#include "maze_dstar.h"
+#include "maze_graph.h"
+#include "maze_hpa.h"
+#include "maze_jps.h"
+#include "maze_path.h"
+#include "maze_tree.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// names accepted by CreatePathFinder()
+inline std::vector<std::string> PathFinderNames()
+{
+    return { "astar", "jps", "hpa", "graph", "tree", "dstar" };
+}
+
+// creates the pathfinder with the given name, or nullptr if there is none
+inline std::unique_ptr<PathFinder> CreatePathFinder(const std::string& name)
+{
+    if (name == "astar") return std::unique_ptr<PathFinder>(new AStarPathFinder());
+    if (name == "jps") return std::unique_ptr<PathFinder>(new JumpPointPathFinder());
+    if (name == "hpa") return std::unique_ptr<PathFinder>(new HierarchicalPathFinder());
+    if (name == "graph") return std::unique_ptr<PathFinder>(new JunctionGraphPathFinder());
+    if (name == "tree") return std::unique_ptr<PathFinder>(new TreePathFinder());
+    if (name == "dstar") return std::unique_ptr<PathFinder>(new DStarLitePathFinder());
+    return nullptr;
+}
+
+// one path query of a batch
+struct PathRequest
+{
+    int StartX;
+    int StartY;
+    int GoalX;
+    int GoalY;
+};
+
+// the paths of a batch back to back, in the order they were asked for
+struct PathBatchResults
+{
+    // cells of every path, path i is Cells[Offsets[i]] .. Cells[Offsets[i + 1] - 1]
+    std::vector<int> Cells;
+    std::vector<int> Offsets;
+    // time from Submit() until the last path was in place
+    double Seconds = 0.0;
+
+    int Count() const { return Offsets.empty() ? 0 : (int)Offsets.size() - 1; }
+    // cells of path i from start to goal, Length(i) is 0 if no path was found
+    const int* Path(int i) const { return Cells.data() + Offsets[i]; }
+    int Length(int i) const { return Offsets[i + 1] - Offsets[i]; }
+};
+
+// Answers a batch of path queries per frame on a pool of worker threads, so the render loop
+// only hands the batch over and picks the paths up a frame later.
+// Every worker has its own pathfinder (and with it its own scratch arrays and caches) and
+// writes paths to its own buffer, workers only share an atomic counter to pull the next few
+// requests. The last worker to finish copies the paths into one contiguous buffer in request
+// order, and Collect() swaps that in for the caller while the next batch fills the other one.
+// The maze must not change between Submit() and the batch being done.
+class MazePathService
+{
+public:
+    // number of worker threads, 0 uses every hardware thread
+    MazePathService(const std::string& finder = "astar", int threads = 0)
+    {
+        int count = threads > 0 ? threads : (int)std::thread::hardware_concurrency();
+        count = std::max(1, count);
+        workers.resize(count);
+        for (int i = 0; i < count; ++i)
+        {
+            workers[i].Finder = CreatePathFinder(finder);
+            if (!workers[i].Finder)
+                workers[i].Finder = CreatePathFinder("astar");
+        }
+        for (int i = 0; i < count; ++i)
+            workers[i].Thread = std::thread([this, i]() { run(i); });
+    }
+
+    ~MazePathService()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (size_t i = 0; i < workers.size(); ++i)
+            workers[i].Thread.join();
+    }
+
+    MazePathService(const MazePathService&) = delete;
+    MazePathService& operator=(const MazePathService&) = delete;
+
+    int Threads() const { return (int)workers.size(); }
+
+    // hands a batch to the workers and returns right away, waits for the previous batch first
+    void Submit(const Maze& maze, const std::vector<PathRequest>& batch)
+    {
+        Wait();
+        std::lock_guard<std::mutex> lock(mutex);
+        requests = batch;
+        current = &maze;
+        located.resize(requests.size());
+        nextRequest = 0;
+        running = (int)workers.size();
+        busy = true;
+        submitted = std::chrono::high_resolution_clock::now();
+        generation++;
+        wake.notify_all();
+    }
+
+    // true once the last batch is done and Collect() won't wait
+    bool Ready()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return !busy;
+    }
+
+    // blocks until the last batch is done
+    void Wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this]() { return !busy; });
+    }
+
+    // paths of the last batch, waiting for it if it isn't done yet. The results stay valid
+    // until the next call to Collect()
+    const PathBatchResults& Collect()
+    {
+        Wait();
+        if (fresh)
+        {
+            std::swap(front, back);
+            fresh = false;
+        }
+        return front;
+    }
+
+private:
+    // where a path landed: which worker's buffer, where in it and how many cells
+    struct Location
+    {
+        int Worker;
+        int Offset;
+        int Length;
+    };
+
+    struct Worker
+    {
+        std::thread Thread;
+        std::unique_ptr<PathFinder> Finder;
+        std::vector<int> Cells;
+        std::vector<int> Path;
+    };
+
+    // requests a worker takes from the batch at a time
+    enum { CHUNK = 8 };
+
+    std::vector<Worker> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    bool stopping = false;
+    bool busy = false;
+    bool fresh = false;
+    uint64_t generation = 0;
+
+    const Maze* current = nullptr;
+    std::vector<PathRequest> requests;
+    std::vector<Location> located;
+    std::atomic<size_t> nextRequest{ 0 };
+    std::atomic<int> running{ 0 };
+    std::chrono::high_resolution_clock::time_point submitted;
+    PathBatchResults front, back;
+
+    void run(int index)
+    {
+        Worker& worker = workers[index];
+        uint64_t seen = 0;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&]() { return stopping || generation != seen; });
+                if (stopping)
+                    return;
+                seen = generation;
+            }
+
+            worker.Cells.clear();
+            size_t count = requests.size();
+            for (size_t first = nextRequest.fetch_add(CHUNK); first < count; first = nextRequest.fetch_add(CHUNK))
+            {
+                for (size_t i = first; i < std::min(count, first + CHUNK); ++i)
+                {
+                    const PathRequest& request = requests[i];
+                    Location& location = located[i];
+                    location.Worker = index;
+                    location.Offset = (int)worker.Cells.size();
+                    location.Length = 0;
+                    if (worker.Finder->FindPath(*current, request.StartX, request.StartY, request.GoalX, request.GoalY, worker.Path))
+                    {
+                        location.Length = (int)worker.Path.size();
+                        worker.Cells.insert(worker.Cells.end(), worker.Path.begin(), worker.Path.end());
+                    }
+                }
+            }
+
+            if (--running == 0)
+            {
+                gather();
+                std::lock_guard<std::mutex> lock(mutex);
+                busy = false;
+                fresh = true;
+                done.notify_all();
+            }
+        }
+    }
+
+    // copies every path into the back buffer in request order
+    void gather()
+    {
+        back.Offsets.resize(requests.size() + 1);
+        size_t total = 0;
+        for (size_t i = 0; i < requests.size(); ++i)
+        {
+            back.Offsets[i] = (int)total;
+            total += located[i].Length;
+        }
+        back.Offsets[requests.size()] = (int)total;
+        back.Cells.resize(total);
+        for (size_t i = 0; i < requests.size(); ++i)
+        {
+            const Location& location = located[i];
+            if (location.Length > 0)
+                std::memcpy(&back.Cells[back.Offsets[i]], &workers[location.Worker].Cells[location.Offset], location.Length * sizeof(int));
+        }
+        back.Seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - submitted).count();
+    }
+};
+#endif
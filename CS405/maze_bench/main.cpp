@@ -0,0 +1,652 @@
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include "../maze.h"
+#include "../maze_batch.h"
+#include "../maze_cache.h"
+#include "../maze_dstar.h"
+#include "../maze_flow.h"
+#include "../maze_generators.h"
+#include "../maze_graph.h"
+#include "../maze_hpa.h"
+#include "../maze_jps.h"
+#include "../maze_parallel.h"
+#include "../maze_path.h"
+#include "../maze_tree.h"
+#include "../maze_wavefront.h"
+using namespace std;
+
+// Headless maze benchmark, no window or GL context needed. Not part of CS405.vcxproj, build it from this folder with
+//   g++ -std=c++17 -O2 -Wall -Wextra -pthread -o maze_bench main.cpp
+// usage: maze_bench [algorithms [maxCells]]          every generator at 1K/16K/256K/16M cells
+//        maze_bench tiled [width height [threads]]   serial vs tiled generation
+//        maze_bench paths [side [queries [algorithm]]] pathfinder latency on a side x side maze
+//        maze_bench flow [side [agents [frames]]]    agents chasing a moving target with one flow field
+//        maze_bench tree [side [queries]]            distance and next step queries on the maze's tree
+//        maze_bench bfs [side [algorithm]]           full distance field, word wavefront vs queue
+//        maze_bench cache [side [queries [finder]]]  patrols between a few waypoints, cached vs not
+//        maze_bench batch [side [agents [threads [finder]]]] a batch of path queries per frame on a worker pool
+//        maze_bench check                            every pathfinder on small mazes that broke one before, exits 1 on a failure
+
+double seconds(chrono::high_resolution_clock::time_point start)
+{
+    return chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+}
+
+void report(const char* name, const Maze& maze, double time, double baseline)
+{
+    double cells = (double)maze.Width * maze.Height;
+    cout << "  " << name << ": " << time * 1000.0 << " ms, " << cells / time / 1e6 << " Mcells/sec";
+    if (baseline > 0.0)
+        cout << ", " << baseline / time << "x serial";
+    cout << endl;
+}
+
+void benchTiled(int width, int height, int threads)
+{
+    Maze maze(width, height);
+    cout << "maze " << width << "x" << height << " (" << maze.MemoryBytes() / (1024.0 * 1024.0) << " MB of wall bits), "
+        << threads << " threads" << endl;
+
+    // serial depth first search
+    auto start = chrono::high_resolution_clock::now();
+    maze.Generate(0, 0, 1);
+    double serial = seconds(start);
+    report("serial", maze, serial, 0.0);
+
+    // tiled, once with a single thread to separate the cost of tiling from the speedup of threading
+    TiledMazeGenerator tiled(256, 256, 1);
+    start = chrono::high_resolution_clock::now();
+    tiled.Generate(maze, 1);
+    report("tiled 1 thread", maze, seconds(start), serial);
+
+    for (int t = 2; t <= threads; t = (t * 2 > threads && t < threads) ? threads : t * 2)
+    {
+        tiled.Threads = t;
+        start = chrono::high_resolution_clock::now();
+        tiled.Generate(maze, 1);
+        string name = "tiled " + to_string(t) + " threads";
+        report(name.c_str(), maze, seconds(start), serial);
+    }
+}
+
+// cells/sec, memory and dead-end ratio of every generator; the dead-end ratio decides how
+// many corridors the level has, which drives geometry and pathfinding costs
+void benchAlgorithms(double maxCells)
+{
+    const int sides[] = { 32, 128, 512, 4096 };
+    cout << left << setw(13) << "algorithm" << right << setw(10) << "cells" << setw(12) << "ms" << setw(14) << "Mcells/sec"
+        << setw(13) << "scratch MB" << setw(11) << "dead ends" << endl;
+    vector<string> names = MazeGeneratorNames();
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+        unique_ptr<MazeGenerator> generator = CreateMazeGenerator(names[i]);
+        for (int side : sides)
+        {
+            if ((double)side * side > maxCells)
+                continue;
+            Maze maze(side, side);
+            auto start = chrono::high_resolution_clock::now();
+            generator->Generate(maze, 1);
+            double time = seconds(start);
+            double cells = (double)side * side;
+            cout << left << setw(13) << generator->Name() << right << setw(10) << (long long)cells
+                << setw(12) << fixed << setprecision(2) << time * 1000.0
+                << setw(14) << cells / time / 1e6
+                << setw(13) << generator->ScratchBytes() / (1024.0 * 1024.0)
+                << setw(11) << setprecision(3) << maze.CountDeadEnds() / cells << endl;
+        }
+    }
+}
+
+// latency of one pathfinder over a list of (start, goal) cell pairs
+void benchPathFinder(PathFinder& finder, const Maze& maze, const vector<int>& pairs, const char* label)
+{
+    vector<int> path;
+    vector<double> times;
+    size_t expanded = 0, length = 0;
+    for (size_t i = 0; i + 1 < pairs.size(); i += 2)
+    {
+        auto start = chrono::high_resolution_clock::now();
+        finder.FindPath(maze, pairs[i] % maze.Width, pairs[i] / maze.Width, pairs[i + 1] % maze.Width, pairs[i + 1] / maze.Width, path);
+        times.push_back(seconds(start) * 1e6);
+        expanded += finder.Expanded();
+        length += path.size();
+    }
+    sort(times.begin(), times.end());
+    double total = 0.0;
+    for (double t : times)
+        total += t;
+    size_t queries = times.size();
+    cout << left << setw(10) << finder.Name() << setw(8) << label << right << fixed << setprecision(1)
+        << setw(12) << total / queries << setw(12) << times[queries / 2] << setw(12) << times[queries * 99 / 100]
+        << setw(14) << (double)expanded / queries << setw(12) << (double)length / queries
+        << setw(13) << finder.ScratchBytes() / (1024.0 * 1024.0) << endl;
+}
+
+// query latency of every pathfinder, once between random cells anywhere in the maze and once
+// between cells at most 16 cells apart, which is what agents chasing the player mostly ask for
+void benchPaths(int side, int queries, string algorithm)
+{
+    Maze maze(side, side);
+    if (algorithm.empty())
+        algorithm = (double)side * side >= 1024.0 * 1024.0 ? "tiled" : "backtracker";
+    unique_ptr<MazeGenerator> generator = CreateMazeGenerator(algorithm);
+    if (!generator)
+    {
+        cout << "unknown algorithm " << algorithm << endl;
+        return;
+    }
+    generator->Generate(maze, 1);
+    Random random(2);
+    vector<int> far, near;
+    for (int i = 0; i < queries; ++i)
+    {
+        far.push_back((int)random.NextInt(side * side));
+        far.push_back((int)random.NextInt(side * side));
+        int x = (int)random.NextInt(side), y = (int)random.NextInt(side);
+        near.push_back(maze.XYToIndex(x, y));
+        x = min(side - 1, max(0, x + (int)random.NextInt(33) - 16));
+        y = min(side - 1, max(0, y + (int)random.NextInt(33) - 16));
+        near.push_back(maze.XYToIndex(x, y));
+    }
+    cout << "maze " << side << "x" << side << " by " << generator->Name() << ", " << queries << " queries each" << endl;
+    cout << left << setw(10) << "finder" << setw(8) << "pairs" << right << setw(12) << "mean us" << setw(12) << "p50 us"
+        << setw(12) << "p99 us" << setw(14) << "expanded" << setw(12) << "length" << setw(13) << "scratch MB" << endl;
+    AStarPathFinder astar;
+    JumpPointPathFinder jps;
+    HierarchicalPathFinder hpa;
+    JunctionGraphPathFinder graph;
+    TreePathFinder tree;
+    vector<PathFinder*> finders = { &astar, &jps, &hpa, &graph, &tree };
+    for (PathFinder* finder : finders)
+    {
+        benchPathFinder(*finder, maze, near, "near");
+        benchPathFinder(*finder, maze, far, "far");
+    }
+
+    // size of the junction graph against the cells it stands for
+    MazeGraph junctions;
+    auto built = chrono::high_resolution_clock::now();
+    junctions.Build(maze);
+    double buildTime = seconds(built);
+    cout << "junction graph: " << junctions.NodeCount() << " nodes (" << fixed << setprecision(1)
+        << (double)side * side / junctions.NodeCount() << "x fewer than cells), " << junctions.EdgeCount() << " edges, "
+        << setprecision(2) << junctions.MemoryBytes() / (1024.0 * 1024.0) << " MB, built in " << buildTime * 1000.0 << " ms" << endl;
+
+    // shifting walls: the first query after a full rebuild against one after a single wall changed
+    vector<int> path;
+    maze.Reset();
+    generator->Generate(maze, 1);
+    auto start = chrono::high_resolution_clock::now();
+    hpa.FindPath(maze, 0, 0, 0, 0, path);
+    double full = seconds(start);
+    size_t fullClusters = hpa.Rebuilt();
+    double changed = 0.0;
+    int changes = min(queries, 1000);
+    for (int i = 0; i < changes; ++i)
+    {
+        int x = (int)random.NextInt(side), y = (int)random.NextInt(side), dir = (int)random.NextInt(4);
+        hpa.SetWall(maze, x, y, dir, maze.HasWall(x, y, dir) ? false : true);
+        start = chrono::high_resolution_clock::now();
+        hpa.FindPath(maze, 0, 0, 0, 0, path);
+        changed += seconds(start);
+    }
+    cout << "hpa rebuild: all " << fullClusters << " clusters " << fixed << setprecision(2) << full * 1000.0
+        << " ms, after one wall changed " << changed / changes * 1e6 << " us" << endl;
+
+    // an agent walking to a far goal while walls toggle, once anywhere in the maze and once on
+    // the path ahead of it: repairing the search tree against planning again from scratch.
+    // A few loops keep most toggles from cutting the agent off from the goal
+    maze.Reset();
+    generator->Generate(maze, 1);
+    for (int i = 0; i < side * side / 20; ++i)
+    {
+        int x = (int)random.NextInt(side), y = (int)random.NextInt(side), dir = (int)random.NextInt(4);
+        if (maze.IsInBounds(x + MAZE_DX[dir], y + MAZE_DY[dir]))
+            maze.Carve(x, y, dir);
+    }
+    for (int onPath = 0; onPath < 2; ++onPath)
+    {
+        DStarLitePathFinder dstar;
+        int agentX = 0, agentY = 0;
+        start = chrono::high_resolution_clock::now();
+        dstar.FindPath(maze, agentX, agentY, side - 1, side - 1, path);
+        double plan = seconds(start);
+        double repaired = 0.0, replanned = 0.0;
+        size_t repairExpanded = 0, replanExpanded = 0;
+        for (int i = 0; i < changes; ++i)
+        {
+            if (path.size() > 1)
+            {
+                agentX = path[1] % side;
+                agentY = path[1] / side;
+            }
+            vector<MazeWallToggle> toggles;
+            for (int k = 0; k < 4; ++k)
+            {
+                int cell = onPath && path.size() > 2 ? path[1 + random.NextInt((uint32_t)path.size() - 1)] : (int)random.NextInt(side * side);
+                toggles.push_back({ cell % side, cell / side, (int)random.NextInt(4) });
+            }
+            dstar.ToggleWalls(maze, toggles);
+            start = chrono::high_resolution_clock::now();
+            astar.FindPath(maze, agentX, agentY, side - 1, side - 1, path);
+            replanned += seconds(start);
+            replanExpanded += astar.Expanded();
+            start = chrono::high_resolution_clock::now();
+            dstar.FindPath(maze, agentX, agentY, side - 1, side - 1, path);
+            repaired += seconds(start);
+            repairExpanded += dstar.Expanded();
+        }
+        cout << "dstar, 4 walls toggled " << (onPath ? "on the path" : "anywhere") << " per step: first plan " << fixed << setprecision(2)
+            << plan * 1000.0 << " ms, repair " << repaired / changes * 1e6 << " us (" << setprecision(1) << (double)repairExpanded / changes
+            << " expanded), A* from scratch " << setprecision(2) << replanned / changes * 1e6 << " us (" << setprecision(1)
+            << (double)replanExpanded / changes << " expanded)" << endl;
+    }
+}
+
+// agents chasing a target that takes a step every frame: one flow field update per frame and
+// a direction read per agent, against one A* per agent
+void benchFlow(int side, int agents, int frames)
+{
+    Maze maze(side, side);
+    CreateMazeGenerator((double)side * side >= 1024.0 * 1024.0 ? "tiled" : "backtracker")->Generate(maze, 1);
+    Random random(3);
+    vector<int> agentX(agents), agentY(agents);
+    for (int i = 0; i < agents; ++i)
+    {
+        agentX[i] = (int)random.NextInt(side);
+        agentY[i] = (int)random.NextInt(side);
+    }
+    int targetX = side / 2, targetY = side / 2;
+
+    MazeFlowField field;
+    auto start = chrono::high_resolution_clock::now();
+    field.Build(maze, targetX, targetY);
+    double build = seconds(start);
+
+    double update = 0.0, steer = 0.0;
+    long long distanceSum = 0;
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        int dir = (int)random.NextInt(4);
+        if (!maze.HasWall(targetX, targetY, dir))
+        {
+            targetX += MAZE_DX[dir];
+            targetY += MAZE_DY[dir];
+        }
+        start = chrono::high_resolution_clock::now();
+        field.MoveTarget(maze, targetX, targetY);
+        update += seconds(start);
+
+        start = chrono::high_resolution_clock::now();
+        for (int i = 0; i < agents; ++i)
+        {
+            int step = field.Direction(agentX[i], agentY[i]);
+            if (step < 4)
+            {
+                agentX[i] += MAZE_DX[step];
+                agentY[i] += MAZE_DY[step];
+            }
+        }
+        steer += seconds(start);
+    }
+    start = chrono::high_resolution_clock::now();
+    for (int i = 0; i < agents; ++i)
+        distanceSum += field.Distance(agentX[i], agentY[i]);
+    double distances = seconds(start);
+
+    // what the same frame costs with a path per agent, timed on a few agents
+    AStarPathFinder astar;
+    vector<int> path;
+    int sampled = min(agents, 20);
+    start = chrono::high_resolution_clock::now();
+    for (int i = 0; i < sampled; ++i)
+        astar.FindPath(maze, agentX[i], agentY[i], targetX, targetY, path);
+    double perAgent = seconds(start) / sampled;
+
+    cout << "maze " << side << "x" << side << ", " << agents << " agents, " << frames << " frames" << endl
+        << fixed << setprecision(2)
+        << "  flow field build " << build * 1000.0 << " ms, " << field.MemoryBytes() / (1024.0 * 1024.0) << " MB" << endl
+        << "  target step " << update / frames * 1e6 << " us, agents steered in " << steer / frames * 1e6 << " us per frame" << endl
+        << "  " << agents << " distance reads " << distances * 1e6 << " us (mean distance " << (double)distanceSum / agents << ")" << endl
+        << "  one A* per agent would be " << perAgent * agents * 1000.0 << " ms per frame" << endl;
+}
+
+// point to point queries answered by the rooted tree of a perfect maze, no search involved
+void benchTree(int side, int queries)
+{
+    Maze maze(side, side);
+    CreateMazeGenerator((double)side * side >= 1024.0 * 1024.0 ? "tiled" : "backtracker")->Generate(maze, 1);
+    MazeTree tree;
+    auto start = chrono::high_resolution_clock::now();
+    if (!tree.Build(maze))
+    {
+        cout << "maze isn't a perfect maze" << endl;
+        return;
+    }
+    double build = seconds(start);
+
+    Random random(4);
+    vector<int> pairs(2 * (size_t)queries);
+    for (int& cell : pairs)
+        cell = (int)random.NextInt(side * side);
+    long long distanceSum = 0, stepSum = 0;
+    start = chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < pairs.size(); i += 2)
+        distanceSum += tree.Distance(pairs[i], pairs[i + 1]);
+    double distances = seconds(start);
+    start = chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < pairs.size(); i += 2)
+        stepSum += tree.NextStep(pairs[i], pairs[i + 1]);
+    double steps = seconds(start);
+
+    cout << "maze " << side << "x" << side << ", " << queries << " random pairs" << endl
+        << fixed << setprecision(2)
+        << "  tree build " << build * 1000.0 << " ms, " << tree.MemoryBytes() / (1024.0 * 1024.0) << " MB" << endl
+        << "  distance " << distances / queries * 1e9 << " ns (" << queries / distances / 1e6 << " M queries/s, mean "
+        << (double)distanceSum / queries << ")" << endl
+        << "  next step " << steps / queries * 1e9 << " ns (" << queries / steps / 1e6 << " M queries/s, direction sum "
+        << stepSum << ")" << endl;
+}
+
+// every agent near the player asking for a path to it each frame: the batch goes to the worker pool
+// and the frame only pays for handing it over and picking up the last one
+void benchBatch(int side, int agents, int threads, string finder)
+{
+    Maze maze(side, side);
+    CreateMazeGenerator((double)side * side >= 1024.0 * 1024.0 ? "tiled" : "backtracker")->Generate(maze, 1);
+    Random random(5);
+    MazePathService service(finder, threads);
+    unique_ptr<PathFinder> serial = CreatePathFinder(finder);
+    if (!serial)
+    {
+        cout << "unknown finder " << finder << endl;
+        return;
+    }
+
+    // the same frames once on this thread alone, then on the pool while this thread renders
+    int frames = 20;
+    vector<vector<PathRequest>> batches(frames + 1, vector<PathRequest>(agents));
+    for (vector<PathRequest>& batch : batches)
+    {
+        int playerX = (int)random.NextInt(side), playerY = (int)random.NextInt(side);
+        // agents roam within 64 cells of the player
+        for (PathRequest& request : batch)
+        {
+            request.StartX = min(side - 1, max(0, playerX + (int)random.NextInt(129) - 64));
+            request.StartY = min(side - 1, max(0, playerY + (int)random.NextInt(129) - 64));
+            request.GoalX = playerX;
+            request.GoalY = playerY;
+        }
+    }
+    vector<int> path;
+    auto start = chrono::high_resolution_clock::now();
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        for (const PathRequest& request : batches[frame])
+            serial->FindPath(maze, request.StartX, request.StartY, request.GoalX, request.GoalY, path);
+    }
+    double serialTime = seconds(start);
+
+    double handOver = 0.0, batchTime = 0.0;
+    size_t cells = 0;
+    for (int frame = 0; frame <= frames; ++frame)
+    {
+        start = chrono::high_resolution_clock::now();
+        const PathBatchResults& results = service.Collect();
+        service.Submit(maze, batches[frame]);
+        double frameTime = seconds(start);
+        // the first frame has nothing to pick up yet
+        if (frame > 0)
+        {
+            handOver += frameTime;
+            batchTime += results.Seconds;
+            cells += results.Cells.size();
+        }
+        // a frame of rendering, long enough for the batch to be done by the next one
+        this_thread::sleep_for(chrono::duration<double>(max(0.016, serialTime / frames * 1.5 / max(1, min(service.Threads(), (int)thread::hardware_concurrency())))));
+    }
+    service.Wait();
+
+    cout << "maze " << side << "x" << side << ", " << agents << " agents, " << finder << " on " << service.Threads() << " threads, "
+        << frames << " frames" << endl
+        << fixed << setprecision(2)
+        << "  batch done in " << batchTime / frames * 1000.0 << " ms, one thread needs " << serialTime / frames * 1000.0 << " ms" << endl
+        << "  render thread spends " << handOver / frames * 1e6 << " us per frame handing over (" << cells / frames << " path cells)" << endl;
+}
+
+// full distance field from the middle of the maze: the word wavefront against a plain queue
+// breadth first search over cells
+void benchBfs(int side, string algorithm)
+{
+    Maze maze(side, side);
+    if (algorithm == "open")
+        maze.OpenAll();
+    else if (CreateMazeGenerator(algorithm))
+        CreateMazeGenerator(algorithm)->Generate(maze, 1);
+    else
+    {
+        cout << "unknown algorithm " << algorithm << endl;
+        return;
+    }
+    int source = maze.XYToIndex(side / 2, side / 2);
+
+    MazeWavefront wavefront;
+    vector<uint32_t> distances;
+    auto start = chrono::high_resolution_clock::now();
+    size_t reached = wavefront.Distances(maze, side / 2, side / 2, distances);
+    double field = seconds(start);
+    start = chrono::high_resolution_clock::now();
+    wavefront.Reach(maze, side / 2, side / 2);
+    double reach = seconds(start);
+
+    vector<uint32_t> queued((size_t)side * side, MazeWavefront::UNREACHABLE);
+    vector<int> queue(queued.size());
+    start = chrono::high_resolution_clock::now();
+    size_t head = 0, tail = 0;
+    queue[tail++] = source;
+    queued[source] = 0;
+    while (head < tail)
+    {
+        int cell = queue[head++];
+        int x = cell % side, y = cell / side;
+        for (int dir = 0; dir < 4; ++dir)
+        {
+            int next = cell + MAZE_DX[dir] + MAZE_DY[dir] * side;
+            if (!maze.HasWall(x, y, dir) && queued[next] == MazeWavefront::UNREACHABLE)
+            {
+                queued[next] = queued[cell] + 1;
+                queue[tail++] = next;
+            }
+        }
+    }
+    double plain = seconds(start);
+
+    cout << "maze " << side << "x" << side << " by " << algorithm << ", " << reached << " cells reached in "
+        << wavefront.Steps() << " steps" << (distances == queued ? "" : " (fields differ!)") << endl
+        << fixed << setprecision(2)
+        << "  wavefront distances " << field * 1000.0 << " ms, reachability only " << reach * 1000.0 << " ms, "
+        << wavefront.MemoryBytes() / (1024.0 * 1024.0) << " MB" << endl
+        << "  queue distances " << plain * 1000.0 << " ms" << endl;
+}
+
+// guards patrolling loops of waypoints ask for the same few paths over and over, now and then
+// a wall moves and every cached path goes
+void benchCache(int side, int queries, string finder)
+{
+    Maze maze(side, side);
+    CreateMazeGenerator((double)side * side >= 1024.0 * 1024.0 ? "tiled" : "backtracker")->Generate(maze, 1);
+    unique_ptr<PathFinder> plain = CreatePathFinder(finder);
+    if (!plain)
+    {
+        cout << "unknown finder " << finder << endl;
+        return;
+    }
+    CachedPathFinder cached(CreatePathFinder(finder), 256);
+
+    // 32 patrols of 4 waypoints each, a query is one leg of a patrol in either direction
+    Random random(6);
+    vector<int> waypoints(32 * 4);
+    for (int& cell : waypoints)
+        cell = (int)random.NextInt(side * side);
+    vector<int> legs;
+    for (int i = 0; i < queries; ++i)
+    {
+        int patrol = (int)random.NextInt(32), leg = (int)random.NextInt(4);
+        int from = waypoints[patrol * 4 + leg], to = waypoints[patrol * 4 + (leg + 1) % 4];
+        if (random.NextInt(2))
+            swap(from, to);
+        legs.push_back(from);
+        legs.push_back(to);
+    }
+
+    vector<int> path;
+    double times[2] = { 0.0, 0.0 };
+    for (int run = 0; run < 2; ++run)
+    {
+        PathFinder& pathFinder = run == 0 ? *plain : cached;
+        // both runs flip the same walls of their own copy
+        Maze level = maze;
+        Random walls(7);
+        for (size_t i = 0; i < legs.size(); i += 2)
+        {
+            // a wall flips every 500 queries
+            if (i / 2 % 500 == 499)
+            {
+                int x = (int)walls.NextInt(side - 1), y = (int)walls.NextInt(side);
+                level.SetWall(x, y, EAST, !level.HasWall(x, y, EAST));
+            }
+            auto start = chrono::high_resolution_clock::now();
+            pathFinder.FindPath(level, legs[i] % side, legs[i] / side, legs[i + 1] % side, legs[i + 1] / side, path);
+            times[run] += seconds(start);
+        }
+    }
+
+    cout << "maze " << side << "x" << side << ", " << queries << " patrol legs by " << finder << endl
+        << fixed << setprecision(2)
+        << "  uncached " << times[0] / queries * 1e6 << " us per query, cached " << times[1] / queries * 1e6 << " us" << endl
+        << "  " << cached.Hits() << " hits, " << cached.Misses() << " misses (" << setprecision(1)
+        << 100.0 * cached.Hits() / queries << "% hit rate), " << cached.Evictions() << " evictions, "
+        << setprecision(2) << cached.MemoryBytes() / (1024.0 * 1024.0) << " MB" << endl;
+}
+
+// true if path is a walk through open walls from (startX,startY) to (goalX,goalY)
+bool isWalk(const Maze& maze, const vector<int>& path, int startX, int startY, int goalX, int goalY)
+{
+    if (path.empty() || path.front() != maze.XYToIndex(startX, startY) || path.back() != maze.XYToIndex(goalX, goalY))
+        return false;
+    for (size_t i = 1; i < path.size(); ++i)
+    {
+        int x = path[i - 1] % maze.Width, y = path[i - 1] / maze.Width;
+        int dir = 0;
+        while (dir < 4 && path[i] != maze.XYToIndex(x + MAZE_DX[dir], y + MAZE_DY[dir]))
+            dir++;
+        if (dir == 4 || maze.HasWall(x, y, dir))
+            return false;
+    }
+    return true;
+}
+
+// regression cases: every pathfinder has to agree with A* on whether there is a path and, if
+// there is, return a walk through the maze of the same length
+int checkPaths()
+{
+    struct Case
+    {
+        const char* Name;
+        Maze Walls;
+        int StartX, StartY, GoalX, GoalY;
+    };
+    vector<Case> cases;
+
+    // columns 0 to 2 are a ring of corridor cells without a junction, column 3 is cut off.
+    // Jump point search used to run around the ring for ever looking for the goal
+    Maze ring(4, 2);
+    ring.Carve(0, 0, EAST);
+    ring.Carve(1, 0, EAST);
+    ring.Carve(2, 0, SOUTH);
+    ring.Carve(2, 1, WEST);
+    ring.Carve(1, 1, WEST);
+    ring.Carve(0, 1, NORTH);
+    cases.push_back({ "corridor ring, goal cut off", ring, 1, 0, 3, 0 });
+    cases.push_back({ "corridor ring, goal on the ring", ring, 1, 0, 1, 1 });
+
+    Maze perfect(64, 64);
+    CreateMazeGenerator("backtracker")->Generate(perfect, 1);
+    cases.push_back({ "perfect maze, corner to corner", perfect, 0, 0, 63, 63 });
+
+    int failures = 0;
+    vector<int> expected, path;
+    for (const Case& test : cases)
+    {
+        AStarPathFinder astar;
+        bool found = astar.FindPath(test.Walls, test.StartX, test.StartY, test.GoalX, test.GoalY, expected);
+        for (const string& name : PathFinderNames())
+        {
+            unique_ptr<PathFinder> finder = CreatePathFinder(name);
+            bool result = finder->FindPath(test.Walls, test.StartX, test.StartY, test.GoalX, test.GoalY, path);
+            bool ok = result == found && (!found || (path.size() == expected.size()
+                && isWalk(test.Walls, path, test.StartX, test.StartY, test.GoalX, test.GoalY)));
+            // the tree only answers perfect mazes
+            if (name == "tree" && !result && !MazeTree().Build(test.Walls))
+                ok = true;
+            if (!ok)
+            {
+                cout << "FAIL " << name << ": " << test.Name << endl;
+                failures++;
+            }
+        }
+    }
+    cout << cases.size() << " cases, " << PathFinderNames().size() << " pathfinders, " << failures << " failures" << endl;
+    return failures == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv)
+{
+    string mode = argc >= 2 ? argv[1] : "algorithms";
+    if (mode == "tiled")
+    {
+        int width = argc >= 4 ? atoi(argv[2]) : 4096;
+        int height = argc >= 4 ? atoi(argv[3]) : 4096;
+        int threads = argc >= 5 ? atoi(argv[4]) : (int)thread::hardware_concurrency();
+        benchTiled(width, height, threads);
+    }
+    else if (mode == "flow")
+    {
+        benchFlow(argc >= 3 ? atoi(argv[2]) : 1024, argc >= 4 ? atoi(argv[3]) : 1000, argc >= 5 ? atoi(argv[4]) : 1000);
+    }
+    else if (mode == "bfs")
+    {
+        benchBfs(argc >= 3 ? atoi(argv[2]) : 4096, argc >= 4 ? argv[3] : "tiled");
+    }
+    else if (mode == "cache")
+    {
+        benchCache(argc >= 3 ? atoi(argv[2]) : 512, argc >= 4 ? atoi(argv[3]) : 2000, argc >= 5 ? argv[4] : "astar");
+    }
+    else if (mode == "batch")
+    {
+        benchBatch(argc >= 3 ? atoi(argv[2]) : 1024, argc >= 4 ? atoi(argv[3]) : 256, argc >= 5 ? atoi(argv[4]) : 0,
+            argc >= 6 ? argv[5] : "hpa");
+    }
+    else if (mode == "tree")
+    {
+        benchTree(argc >= 3 ? atoi(argv[2]) : 1024, argc >= 4 ? atoi(argv[3]) : 1000000);
+    }
+    else if (mode == "check")
+    {
+        return checkPaths();
+    }
+    else if (mode == "paths")
+    {
+        benchPaths(argc >= 3 ? atoi(argv[2]) : 1024, argc >= 4 ? atoi(argv[3]) : 1000, argc >= 5 ? argv[4] : "");
+    }
+    else
+    {
+        benchAlgorithms(argc >= 3 ? atof(argv[2]) : 16.0 * 1024 * 1024);
+    }
+    return 0;
+}
@@ -0,0 +1,187 @@
+#ifndef MAZE_CACHE_H
+#define MAZE_CACHE_H
+
+#include "maze.h"
+#include "maze_path.h"
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Remembers the last Capacity paths another pathfinder found, keyed by start and goal cell.
+// The cache belongs to one Maze::Revision(): any wall changed through the maze gives it a new
+// revision and the next query empties the cache, so a path is never served for walls it
+// wasn't found on. Paths are undirected, a miss on (start, goal) is answered from a cached
+// (goal, start) path turned around.
+//
+// Entries live in one vector linked from most to least recently used, so the cache only
+// allocates while it grows and evicting reuses the path buffer of the oldest entry. Emptying
+// the cache keeps the entries and their buffers for the paths found after it.
+class CachedPathFinder : public PathFinder
+{
+public:
+    // number of paths kept
+    size_t Capacity;
+
+    CachedPathFinder(std::unique_ptr<PathFinder> finder, size_t capacity = 1024)
+        : Capacity(capacity > 0 ? capacity : 1), finder(std::move(finder))
+    {
+    }
+
+    const char* Name() const override { return "cached"; }
+
+    PathFinder& Finder() { return *finder; }
+
+    size_t Hits() const { return hits; }
+    size_t Misses() const { return misses; }
+    // entries dropped to stay within Capacity or because the maze changed
+    size_t Evictions() const { return evictions; }
+
+    void ResetCounters()
+    {
+        hits = misses = evictions = 0;
+    }
+
+    void Clear()
+    {
+        evictions += index.size();
+        index.clear();
+        used = 0;
+        head = tail = -1;
+    }
+
+    bool FindPath(const Maze& maze, int startX, int startY, int goalX, int goalY, std::vector<int>& path) override
+    {
+        path.clear();
+        expanded = 0;
+        if (!maze.IsInBounds(startX, startY) || !maze.IsInBounds(goalX, goalY))
+            return false;
+        if (maze.Revision() != revision)
+        {
+            Clear();
+            revision = maze.Revision();
+        }
+        uint32_t start = (uint32_t)maze.XYToIndex(startX, startY);
+        uint32_t goal = (uint32_t)maze.XYToIndex(goalX, goalY);
+
+        auto found = index.find(key(start, goal));
+        bool reversed = false;
+        if (found == index.end())
+        {
+            found = index.find(key(goal, start));
+            reversed = true;
+        }
+        if (found != index.end())
+        {
+            hits++;
+            Entry& entry = entries[found->second];
+            touch(found->second);
+            if (reversed)
+                path.assign(entry.Path.rbegin(), entry.Path.rend());
+            else
+                path = entry.Path;
+            return entry.Found;
+        }
+
+        misses++;
+        bool result = finder->FindPath(maze, startX, startY, goalX, goalY, path);
+        expanded = finder->Expanded();
+        int slot = allocate(key(start, goal));
+        entries[slot].Path = path;
+        entries[slot].Found = result;
+        scratchBytes = finder->ScratchBytes() + MemoryBytes();
+        return result;
+    }
+
+    size_t MemoryBytes() const
+    {
+        size_t bytes = entries.capacity() * sizeof(Entry) + index.size() * (sizeof(uint64_t) + sizeof(int) + 2 * sizeof(void*));
+        for (size_t i = 0; i < entries.size(); ++i)
+            bytes += entries[i].Path.capacity() * sizeof(int);
+        return bytes;
+    }
+
+private:
+    struct Entry
+    {
+        uint64_t Key;
+        std::vector<int> Path;
+        bool Found;
+        // neighbours in the recently used list
+        int Newer;
+        int Older;
+    };
+
+    std::unique_ptr<PathFinder> finder;
+    uint64_t revision = 0;
+    std::vector<Entry> entries;
+    // entries in use, the ones after them are free slots left by Clear()
+    size_t used = 0;
+    std::unordered_map<uint64_t, int> index;
+    // most and least recently used entries
+    int head = -1, tail = -1;
+    size_t hits = 0, misses = 0, evictions = 0;
+
+    static uint64_t key(uint32_t start, uint32_t goal)
+    {
+        return ((uint64_t)start << 32) | goal;
+    }
+
+    void unlink(int slot)
+    {
+        Entry& entry = entries[slot];
+        if (entry.Newer >= 0)
+            entries[entry.Newer].Older = entry.Older;
+        else
+            head = entry.Older;
+        if (entry.Older >= 0)
+            entries[entry.Older].Newer = entry.Newer;
+        else
+            tail = entry.Newer;
+    }
+
+    void pushFront(int slot)
+    {
+        entries[slot].Newer = -1;
+        entries[slot].Older = head;
+        if (head >= 0)
+            entries[head].Newer = slot;
+        head = slot;
+        if (tail < 0)
+            tail = slot;
+    }
+
+    // moves an entry to the front of the list
+    void touch(int slot)
+    {
+        if (slot == head)
+            return;
+        unlink(slot);
+        pushFront(slot);
+    }
+
+    // slot for a new entry, the least recently used one once the cache is full
+    int allocate(uint64_t entryKey)
+    {
+        int slot;
+        if (used < Capacity)
+        {
+            slot = (int)used++;
+            if (slot == (int)entries.size())
+                entries.push_back(Entry());
+        }
+        else
+        {
+            slot = tail;
+            unlink(slot);
+            index.erase(entries[slot].Key);
+            evictions++;
+        }
+        entries[slot].Key = entryKey;
+        index[entryKey] = slot;
+        pushFront(slot);
+        return slot;
+    }
+};
+#endif
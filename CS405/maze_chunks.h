@@ -0,0 +1,182 @@
+#ifndef MAZE_CHUNKS_H
+#define MAZE_CHUNKS_H
+
+#include <glm/glm.hpp>
+
+#include "maze_mesh.h"
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// The six planes of the camera's view volume, taken from the projection * view matrix
+// (Gribb and Hartmann), every plane facing inwards.
+struct MazeFrustum
+{
+    glm::vec4 Planes[6];
+
+    explicit MazeFrustum(const glm::mat4& viewProjection)
+    {
+        // glm matrices are column major, m[column][row]
+        const glm::mat4& m = viewProjection;
+        for (int i = 0; i < 3; i++)
+        {
+            glm::vec4 row(m[0][i], m[1][i], m[2][i], m[3][i]);
+            glm::vec4 w(m[0][3], m[1][3], m[2][3], m[3][3]);
+            Planes[2 * i] = w + row;
+            Planes[2 * i + 1] = w - row;
+        }
+    }
+
+    // false if the box is entirely outside one of the planes
+    bool Intersects(glm::vec3 min, glm::vec3 max) const
+    {
+        for (int i = 0; i < 6; i++)
+        {
+            const glm::vec4& plane = Planes[i];
+            // the corner of the box farthest along the plane's normal
+            glm::vec3 corner(plane.x >= 0.0f ? max.x : min.x, plane.y >= 0.0f ? max.y : min.y, plane.z >= 0.0f ? max.z : min.z);
+            if (plane.x * corner.x + plane.y * corner.y + plane.z * corner.z + plane.w < 0.0f)
+                return false;
+        }
+        return true;
+    }
+};
+
+// The maze's quads split into chunks of CHUNK_CELLS x CHUNK_CELLS grid cells, every chunk
+// with its own MazeMesh (buffers and one index range per material) and the box around it.
+// Adding quads only rebuilds the chunks they fall in, streaming rows in and out of the
+// endless maze touches a row of chunks, and a frame draws just the chunks whose box is in
+// the view, so its cost follows what the camera sees rather than the size of the maze.
+class MazeChunks
+{
+public:
+    // grid cells along each side of a chunk, a grid cell is 3 units of world space
+    enum { CHUNK_CELLS = 8 };
+
+    // adds the unit plane at pos, rotated by rotation degrees around axis, to its chunk
+    void AddQuad(int material, glm::vec3 pos, float rotation, glm::vec3 axis)
+    {
+        long long x = (long long)std::floor(pos.x / 3.0f + 0.5f);
+        long long y = (long long)std::floor(pos.z / 3.0f + 0.5f);
+        Chunk& chunk = chunkAt(floorDiv(x), floorDiv(y));
+        chunk.Mesh.AddQuad(material, pos, rotation, axis);
+        chunk.Dirty = true;
+    }
+
+    // drops the chunks whose grid rows all lie before gridRow
+    void RemoveRowsBefore(long long gridRow)
+    {
+        for (auto it = chunks.begin(); it != chunks.end();)
+        {
+            if ((it->second->Y + 1) * CHUNK_CELLS <= gridRow)
+            {
+                it->second->Mesh.Release();
+                it = chunks.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        visible.clear();
+    }
+
+    // merges and uploads the chunks quads were added to since the last call, returns how many
+    size_t Upload()
+    {
+        size_t uploaded = 0;
+        for (auto& entry : chunks)
+        {
+            Chunk& chunk = *entry.second;
+            if (!chunk.Dirty)
+                continue;
+            chunk.Mesh.Upload();
+            chunk.Dirty = false;
+            uploaded++;
+        }
+        return uploaded;
+    }
+
+    // picks the chunks the next Draw() calls draw
+    void Cull(const MazeFrustum& frustum)
+    {
+        visible.clear();
+        for (auto& entry : chunks)
+        {
+            const MazeMesh& mesh = entry.second->Mesh;
+            if (!mesh.Empty() && frustum.Intersects(mesh.BoundsMin(), mesh.BoundsMax()))
+                visible.push_back(&mesh);
+        }
+    }
+
+    // draws one material of every chunk that passed Cull(), the caller binds its textures first
+    void Draw(int material) const
+    {
+        for (size_t i = 0; i < visible.size(); i++)
+            visible[i]->Draw(material);
+    }
+
+    size_t ChunkCount() const { return chunks.size(); }
+    size_t VisibleCount() const { return visible.size(); }
+    const std::vector<const MazeMesh*>& Visible() const { return visible; }
+
+    // quads added to every chunk and the rectangles they were merged into
+    size_t AddedQuads() const
+    {
+        size_t count = 0;
+        for (auto& entry : chunks)
+            count += entry.second->Mesh.AddedQuads();
+        return count;
+    }
+
+    size_t QuadCount(int material) const
+    {
+        size_t count = 0;
+        for (auto& entry : chunks)
+            count += entry.second->Mesh.QuadCount(material);
+        return count;
+    }
+
+    // deletes every chunk and its buffers, call while the GL context is still alive
+    void Release()
+    {
+        for (auto& entry : chunks)
+            entry.second->Mesh.Release();
+        chunks.clear();
+        visible.clear();
+    }
+
+private:
+    struct Chunk
+    {
+        long long X;
+        long long Y;
+        MazeMesh Mesh;
+        bool Dirty = false;
+    };
+
+    std::unordered_map<uint64_t, std::unique_ptr<Chunk>> chunks;
+    std::vector<const MazeMesh*> visible;
+
+    static long long floorDiv(long long v)
+    {
+        return v >= 0 ? v / CHUNK_CELLS : -((-v + CHUNK_CELLS - 1) / CHUNK_CELLS);
+    }
+
+    Chunk& chunkAt(long long x, long long y)
+    {
+        uint64_t key = ((uint64_t)(uint32_t)x << 32) | (uint32_t)y;
+        std::unique_ptr<Chunk>& chunk = chunks[key];
+        if (!chunk)
+        {
+            chunk.reset(new Chunk());
+            chunk->X = x;
+            chunk->Y = y;
+        }
+        return *chunk;
+    }
+};
+#endif
@@ -0,0 +1,266 @@
+#include <bitset>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../maze.h"
+#include "../maze_export.h"
+#include "../maze_file.h"
+#include "../maze_generators.h"
+using namespace std;
+
+// Headless maze toolchain, no window or GL context needed. Not part of CS405.vcxproj, build it from this folder with
+//   g++ -std=c++17 -O2 -Wall -Wextra -pthread -o maze_cli main.cpp
+// usage: maze_cli generate width height out [--seed n] [--algorithm name] [--format f]
+//        maze_cli export in.maze out [--format f]
+//        maze_cli validate in.maze
+//        maze_cli info in.maze
+// f is one of maze, ascii, pbm, png and is taken from the extension of out if not given.
+
+double seconds(chrono::high_resolution_clock::time_point start)
+{
+    return chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+}
+
+string formatOf(const string& path, const string& format)
+{
+    if (!format.empty())
+        return format;
+    size_t dot = path.rfind('.');
+    string extension = dot == string::npos ? "" : path.substr(dot + 1);
+    if (extension == "txt")
+        return "ascii";
+    if (extension == "pbm" || extension == "png")
+        return extension;
+    return "maze";
+}
+
+bool exportMaze(const Maze& maze, uint64_t seed, const char* algorithm, const string& path, const string& format)
+{
+    auto start = chrono::high_resolution_clock::now();
+    bool ok = false;
+    if (format == "ascii")
+        ok = ExportMazeAscii(maze, path);
+    else if (format == "pbm")
+        ok = ExportMazePbm(maze, path);
+    else if (format == "png")
+        ok = ExportMazePng(maze, path);
+    else if (format == "maze")
+    {
+        MazeFileMeta meta = MakeMazeFileMeta(maze, algorithm);
+        ok = SaveMazeFile(path, maze, seed, &meta);
+    }
+    else
+    {
+        cout << "unknown format " << format << endl;
+        return false;
+    }
+    if (!ok)
+    {
+        cout << "could not write " << path << endl;
+        return false;
+    }
+    cout << "wrote " << path << " (" << format << ") in " << seconds(start) * 1000.0 << " ms" << endl;
+    return true;
+}
+
+// union-find root with path halving
+int find(vector<int>& parent, int i)
+{
+    while (parent[i] != i)
+    {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+// checks that the maze is perfect (every cell reachable by exactly one path) and that the
+// outer wall is closed. Works one row at a time with a union-find over the sets of the
+// current row, like Eller's algorithm, so it needs O(width) memory for any height: a cycle
+// is an open wall between two cells that are already connected, and a maze without
+// cycles and with exactly cells - 1 open walls is connected.
+bool validateMaze(const Maze& maze)
+{
+    if (maze.Width <= 0 || maze.Height <= 0)
+    {
+        cout << "empty maze" << endl;
+        return false;
+    }
+    int width = maze.Width;
+    int words = maze.WordsPerRow();
+    // bits of the last word that belong to cells, the east wall of the last column is the outer wall
+    uint64_t lastMask = (width & 63) ? (1ull << (width & 63)) - 1 : ~0ull;
+    uint64_t lastEastMask = lastMask & ~(1ull << ((width - 1) & 63));
+    vector<int> sets(width, -1), next(width), parent(2 * width), renumber(2 * width);
+    uint64_t openWalls = 0;
+    bool ok = true;
+    for (int y = 0; y < maze.Height; ++y)
+    {
+        const uint64_t* east = maze.EastWalls(y);
+        const uint64_t* south = maze.SouthWalls(y);
+        if (!((east[(width - 1) >> 6] >> ((width - 1) & 63)) & 1))
+        {
+            cout << "outer wall open east of cell (" << width - 1 << "," << y << ")" << endl;
+            ok = false;
+        }
+        for (int i = 0; i < words; ++i)
+        {
+            uint64_t mask = i == words - 1 ? lastMask : ~0ull;
+            openWalls += bitset<64>(~east[i] & (i == words - 1 ? lastEastMask : ~0ull)).count();
+            if (y + 1 < maze.Height)
+                openWalls += bitset<64>(~south[i] & mask).count();
+            else if ((~south[i] & mask) != 0)
+            {
+                cout << "outer wall open on the south side of row " << y << endl;
+                ok = false;
+            }
+        }
+
+        int count = 0;
+        for (int x = 0; x < width; ++x)
+        {
+            if (sets[x] < 0)
+                sets[x] = 2 * width - 1 - count++;
+        }
+        for (int i = 0; i < 2 * width; ++i)
+            parent[i] = i;
+        for (int x = 0; x + 1 < width; ++x)
+        {
+            if ((east[x >> 6] >> (x & 63)) & 1)
+                continue;
+            int a = find(parent, sets[x]);
+            int b = find(parent, sets[x + 1]);
+            if (a == b)
+            {
+                cout << "cycle through the wall east of cell (" << x << "," << y << ")" << endl;
+                return false;
+            }
+            parent[a] = b;
+        }
+
+        // sets carried into the next row are renumbered 0..k-1, new sets count down from 2 * width - 1
+        for (int i = 0; i < 2 * width; ++i)
+            renumber[i] = -1;
+        int carried = 0;
+        for (int x = 0; x < width; ++x)
+        {
+            next[x] = -1;
+            if (y + 1 < maze.Height && !((south[x >> 6] >> (x & 63)) & 1))
+            {
+                int set = find(parent, sets[x]);
+                if (renumber[set] < 0)
+                    renumber[set] = carried++;
+                next[x] = renumber[set];
+            }
+        }
+        sets.swap(next);
+    }
+
+    uint64_t cells = (uint64_t)maze.Width * maze.Height;
+    if (openWalls != cells - 1)
+    {
+        cout << openWalls << " open walls, a perfect maze of " << cells << " cells has " << cells - 1
+            << (openWalls < cells - 1 ? ", some cells can't be reached" : "") << endl;
+        ok = false;
+    }
+    return ok;
+}
+
+int usage()
+{
+    cout << "usage: maze_cli generate width height out [--seed n] [--algorithm name] [--format maze|ascii|pbm|png]" << endl
+        << "       maze_cli export in.maze out [--format maze|ascii|pbm|png]" << endl
+        << "       maze_cli validate in.maze" << endl
+        << "       maze_cli info in.maze" << endl;
+    return 1;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+        return usage();
+    string command = argv[1];
+
+    // options can follow the positional arguments of any command
+    vector<string> args;
+    uint64_t seed = 1;
+    string algorithm, format;
+    for (int i = 2; i < argc; ++i)
+    {
+        string arg = argv[i];
+        if (arg == "--seed" && i + 1 < argc)
+            seed = strtoull(argv[++i], NULL, 10);
+        else if (arg == "--algorithm" && i + 1 < argc)
+            algorithm = argv[++i];
+        else if (arg == "--format" && i + 1 < argc)
+            format = argv[++i];
+        else
+            args.push_back(arg);
+    }
+
+    if (command == "generate")
+    {
+        if (args.size() < 3)
+            return usage();
+        int width = atoi(args[0].c_str());
+        int height = atoi(args[1].c_str());
+        if (width <= 0 || height <= 0)
+            return usage();
+        if (algorithm.empty())
+            algorithm = (double)width * height >= 1024.0 * 1024.0 ? "tiled" : "backtracker";
+        unique_ptr<MazeGenerator> generator = CreateMazeGenerator(algorithm);
+        if (!generator)
+        {
+            cout << "unknown algorithm " << algorithm << endl;
+            return 1;
+        }
+        Maze maze(width, height);
+        auto start = chrono::high_resolution_clock::now();
+        generator->Generate(maze, seed);
+        double time = seconds(start);
+        cout << "generated " << width << "x" << height << " with " << generator->Name() << " (seed " << seed << ") in "
+            << time * 1000.0 << " ms, " << (double)width * height / time / 1e6 << " Mcells/sec" << endl;
+        return exportMaze(maze, seed, generator->Name(), args[2], formatOf(args[2], format)) ? 0 : 1;
+    }
+
+    // the other commands read a maze file first
+    if (args.empty() || (command == "export" && args.size() < 2))
+        return usage();
+    Maze maze;
+    MazeFileHeader header;
+    MazeFileMeta meta;
+    auto start = chrono::high_resolution_clock::now();
+    if (!LoadMazeFile(args[0], maze, &header, &meta))
+        return 1;
+    double loadTime = seconds(start);
+
+    if (command == "export")
+    {
+        return exportMaze(maze, header.Seed, meta.Algorithm, args[1], formatOf(args[1], format)) ? 0 : 1;
+    }
+    if (command == "validate")
+    {
+        start = chrono::high_resolution_clock::now();
+        bool ok = validateMaze(maze);
+        cout << args[0] << (ok ? " is a perfect maze" : " is not a perfect maze") << " (checked in " << seconds(start) * 1000.0 << " ms)" << endl;
+        if (ok && (header.Flags & MAZE_FILE_HAS_META) && meta.DeadEnds != maze.CountDeadEnds())
+        {
+            cout << "stored dead end count " << meta.DeadEnds << " doesn't match the maze" << endl;
+            ok = false;
+        }
+        return ok ? 0 : 1;
+    }
+    if (command == "info")
+    {
+        cout << args[0] << ": version " << header.Version << ", " << header.Width << "x" << header.Height << " cells, seed " << header.Seed
+            << ", " << header.WallsSize / (1024.0 * 1024.0) << " MB of wall bits, mapped in " << loadTime * 1000.0 << " ms" << endl;
+        if (header.Flags & MAZE_FILE_HAS_META)
+            cout << "generated by " << meta.Algorithm << ", " << meta.DeadEnds << " dead ends, start (" << meta.StartX << "," << meta.StartY
+                << "), exit (" << meta.ExitX << "," << meta.ExitY << ")" << endl;
+        return 0;
+    }
+    return usage();
+}
@@ -0,0 +1,247 @@
+#ifndef MAZE_DSTAR_H
+#define MAZE_DSTAR_H
+
+#include "maze.h"
+#include "maze_path.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// one wall to flip, the side of cell (x,y) in direction Dir
+struct MazeWallToggle
+{
+    int X;
+    int Y;
+    int Dir;
+};
+
+// D* Lite: an A* that runs backwards from the goal and keeps its search tree between queries.
+// Every cell has g, the distance to the goal the search settled on, and rhs, one more than the
+// best g among its open neighbours. A cell whose two disagree is on the open list. A changed
+// wall only makes its two cells recompute rhs, and the next query expands just the cells whose
+// distance really changed (plus what it takes to prove the start's distance), so repairing
+// the tree costs about the size of the change instead of a new search. The start may move
+// between queries as an agent walks; the key modifier km keeps the old heuristics valid.
+//
+// Walls have to be changed through SetWall() or ToggleWalls() for the tree to be repaired,
+// any other change to the maze (a new Maze::Revision()) or a new goal starts over.
+class DStarLitePathFinder : public PathFinder
+{
+public:
+    const char* Name() const override { return "dstar"; }
+
+    // changes a wall like Maze::SetWall() and queues its two cells for the next query to repair
+    void SetWall(Maze& maze, int x, int y, int dir, bool wall)
+    {
+        // walls of the outer border and of cells outside the maze are left alone, like Maze::SetWall() does
+        if (!maze.IsInBounds(x, y) || !maze.IsInBounds(x + MAZE_DX[dir], y + MAZE_DY[dir]))
+            return;
+        bool current = plannedRevision == maze.Revision();
+        maze.SetWall(x, y, dir, wall);
+        if (!current || goal < 0)
+            return;
+        plannedRevision = maze.Revision();
+        int cell = maze.XYToIndex(x, y);
+        updateCell(maze, cell);
+        updateCell(maze, cell + MAZE_DX[dir] + MAZE_DY[dir] * width);
+    }
+
+    // flips every wall in the list, standing walls come down and open ones go up
+    void ToggleWalls(Maze& maze, const std::vector<MazeWallToggle>& toggles)
+    {
+        for (size_t i = 0; i < toggles.size(); ++i)
+        {
+            const MazeWallToggle& toggle = toggles[i];
+            if (maze.IsInBounds(toggle.X, toggle.Y))
+                SetWall(maze, toggle.X, toggle.Y, toggle.Dir, !maze.HasWall(toggle.X, toggle.Y, toggle.Dir));
+        }
+    }
+
+    bool FindPath(const Maze& maze, int startX, int startY, int goalX, int goalY, std::vector<int>& path) override
+    {
+        path.clear();
+        expanded = 0;
+        if (!maze.IsInBounds(startX, startY) || !maze.IsInBounds(goalX, goalY))
+            return false;
+        int newStart = maze.XYToIndex(startX, startY);
+        int newGoal = maze.XYToIndex(goalX, goalY);
+        if (plannedRevision != maze.Revision() || newGoal != goal || maze.Width != width || maze.Height != height)
+        {
+            initialize(maze, newStart, newGoal);
+        }
+        else if (newStart != start)
+        {
+            // every key in the open list is now too big by at most the distance the start moved
+            km += heuristic(start, newStart);
+            start = newStart;
+        }
+        computeShortestPath(maze);
+        scratchBytes = (g.capacity() + rhs.capacity()) * sizeof(uint32_t) + openKey.capacity() * sizeof(uint64_t) + open.capacity() * sizeof(Entry);
+        if (g[start] >= INFINITE)
+            return false;
+
+        // walk down the distances, every step is to a neighbour one closer to the goal
+        path.reserve(g[start] + 1);
+        int cell = start;
+        path.push_back(cell);
+        while (cell != goal)
+        {
+            int x = cell % width, y = cell / width;
+            int best = -1;
+            for (int dir = 0; dir < 4; ++dir)
+            {
+                if (maze.HasWall(x, y, dir))
+                    continue;
+                int next = cell + MAZE_DX[dir] + MAZE_DY[dir] * width;
+                if (best < 0 || g[next] < g[best])
+                    best = next;
+            }
+            cell = best;
+            path.push_back(cell);
+        }
+        return true;
+    }
+
+private:
+    enum : uint32_t { INFINITE = 0x3FFFFFFF };
+    // openKey of a cell that isn't on the open list
+    enum : uint64_t { CLOSED = ~0ull };
+
+    struct Entry
+    {
+        uint64_t Key;
+        int Cell;
+        bool operator<(const Entry& other) const { return Key > other.Key; }
+    };
+
+    int width = 0, height = 0;
+    int start = -1, goal = -1;
+    uint32_t km = 0;
+    uint64_t plannedRevision = 0;
+    std::vector<uint32_t> g;
+    std::vector<uint32_t> rhs;
+    // key a cell was last queued with, heap entries with any other key are stale
+    std::vector<uint64_t> openKey;
+    std::vector<Entry> open;
+
+    uint32_t heuristic(int a, int b) const
+    {
+        return (uint32_t)MazeManhattan(a % width, a / width, b % width, b / width);
+    }
+
+    // (min(g, rhs) + h + km, min(g, rhs)) packed so that comparing the numbers compares the pairs
+    uint64_t key(int cell) const
+    {
+        uint64_t best = std::min(g[cell], rhs[cell]);
+        return ((best + heuristic(start, cell) + km) << 32) | best;
+    }
+
+    void initialize(const Maze& maze, int newStart, int newGoal)
+    {
+        width = maze.Width;
+        height = maze.Height;
+        plannedRevision = maze.Revision();
+        start = newStart;
+        goal = newGoal;
+        km = 0;
+        size_t cells = (size_t)width * height;
+        g.assign(cells, INFINITE);
+        rhs.assign(cells, INFINITE);
+        openKey.assign(cells, CLOSED);
+        open.clear();
+        rhs[goal] = 0;
+        queue(goal, key(goal));
+    }
+
+    void queue(int cell, uint64_t cellKey)
+    {
+        openKey[cell] = cellKey;
+        open.push_back({ cellKey, cell });
+        std::push_heap(open.begin(), open.end());
+        // stale entries deep in the heap never reach the top, drop them once they pile up
+        if (open.size() > 2 * openKey.size() + 1024)
+        {
+            open.erase(std::remove_if(open.begin(), open.end(), [&](const Entry& entry) { return openKey[entry.Cell] != entry.Key; }), open.end());
+            std::make_heap(open.begin(), open.end());
+        }
+    }
+
+    // drops stale entries from the top of the heap
+    void clean()
+    {
+        while (!open.empty() && openKey[open.front().Cell] != open.front().Key)
+        {
+            std::pop_heap(open.begin(), open.end());
+            open.pop_back();
+        }
+    }
+
+    // one more than the best g among the open neighbours of cell
+    uint32_t lookahead(const Maze& maze, int cell) const
+    {
+        int x = cell % width, y = cell / width;
+        uint32_t best = INFINITE;
+        for (int dir = 0; dir < 4; ++dir)
+        {
+            if (!maze.HasWall(x, y, dir))
+                best = std::min(best, g[cell + MAZE_DX[dir] + MAZE_DY[dir] * width] + 1);
+        }
+        return std::min(best, (uint32_t)INFINITE);
+    }
+
+    // recomputes rhs of cell and puts it on the open list, or takes it off, to match
+    void updateCell(const Maze& maze, int cell)
+    {
+        if (cell != goal)
+            rhs[cell] = lookahead(maze, cell);
+        if (g[cell] != rhs[cell])
+            queue(cell, key(cell));
+        else
+            openKey[cell] = CLOSED;
+    }
+
+    void updateNeighbours(const Maze& maze, int cell)
+    {
+        int x = cell % width, y = cell / width;
+        for (int dir = 0; dir < 4; ++dir)
+        {
+            if (!maze.HasWall(x, y, dir))
+                updateCell(maze, cell + MAZE_DX[dir] + MAZE_DY[dir] * width);
+        }
+    }
+
+    void computeShortestPath(const Maze& maze)
+    {
+        clean();
+        while (!open.empty() && (open.front().Key < key(start) || rhs[start] != g[start]))
+        {
+            Entry top = open.front();
+            std::pop_heap(open.begin(), open.end());
+            open.pop_back();
+            int cell = top.Cell;
+            uint64_t current = key(cell);
+            if (top.Key < current)
+            {
+                // queued before the start moved, its key only grew
+                queue(cell, current);
+            }
+            else if (g[cell] > rhs[cell])
+            {
+                expanded++;
+                g[cell] = rhs[cell];
+                openKey[cell] = CLOSED;
+                updateNeighbours(maze, cell);
+            }
+            else
+            {
+                expanded++;
+                g[cell] = INFINITE;
+                updateCell(maze, cell);
+                updateNeighbours(maze, cell);
+            }
+            clean();
+        }
+    }
+};
+#endif
@@ -0,0 +1,352 @@
+#ifndef MAZE_EXPORT_H
+#define MAZE_EXPORT_H
+
+#include "maze.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Writers that turn a Maze into ASCII, PBM or PNG images of its character grid.
+// Nothing here needs a window or a GL context. Every grid row is built as packed bits
+// straight from the wall planes and handed to the file through a large buffer, so a
+// 100M cell maze goes out with a few hundred fwrite() calls instead of one call per char.
+
+// spreads the low 32 bits of v to the even bits of the result, bit i goes to bit 2i
+inline uint64_t mazeSpreadBits(uint64_t v)
+{
+    v &= 0xFFFFFFFFull;
+    v = (v | (v << 16)) & 0x0000FFFF0000FFFFull;
+    v = (v | (v << 8)) & 0x00FF00FF00FF00FFull;
+    v = (v | (v << 4)) & 0x0F0F0F0F0F0F0F0Full;
+    v = (v | (v << 2)) & 0x3333333333333333ull;
+    v = (v | (v << 1)) & 0x5555555555555555ull;
+    return v;
+}
+
+// number of words MazeGridRow() writes
+inline int MazeGridRowWords(const Maze& maze)
+{
+    return (maze.GridWidth() + 63) / 64;
+}
+
+// writes grid row gy as bits, bit x is set if the grid position (x,gy) is a wall,
+// the same answer as !maze.IsOpen(x, gy) but 32 cells per step
+inline void MazeGridRow(const Maze& maze, int gy, uint64_t* row)
+{
+    int words = MazeGridRowWords(maze);
+    int gridWidth = maze.GridWidth();
+    if (gy <= 0 || gy >= maze.GridHeight() - 1)
+    {
+        for (int i = 0; i < words; ++i)
+            row[i] = ~0ull;
+    }
+    else
+    {
+        for (int i = 0; i < words; ++i)
+            row[i] = 0;
+        // cell rows have their east walls on the even columns 2x+2, wall rows have the
+        // south walls on the odd columns 2x+1 and a wall on every even column
+        bool cellRow = (gy & 1) != 0;
+        const uint64_t* plane = cellRow ? maze.EastWalls(gy / 2) : maze.SouthWalls(gy / 2 - 1);
+        int shift = cellRow ? 2 : 1;
+        int halves = (maze.Width + 31) / 32;
+        for (int j = 0; j < halves; ++j)
+        {
+            uint64_t v = mazeSpreadBits(plane[j >> 1] >> ((j & 1) * 32));
+            row[j] |= v << shift;
+            if (j + 1 < words)
+                row[j + 1] |= v >> (64 - shift);
+        }
+        if (!cellRow)
+        {
+            for (int i = 0; i < words; ++i)
+                row[i] |= 0x5555555555555555ull;
+        }
+        row[0] |= 1;
+    }
+    // the last column is always the outer wall, and nothing past it is set
+    row[(gridWidth - 1) >> 6] |= 1ull << ((gridWidth - 1) & 63);
+    if (gridWidth & 63)
+        row[words - 1] &= (1ull << (gridWidth & 63)) - 1;
+}
+
+// collects small writes in a large buffer and hands them to the file in bulk
+class MazeFileWriter
+{
+public:
+    MazeFileWriter(const std::string& path, size_t bufferSize = 4 << 20) : buffer(bufferSize)
+    {
+        file = fopen(path.c_str(), "wb");
+    }
+
+    ~MazeFileWriter()
+    {
+        Close();
+    }
+
+    bool IsOpen() const { return file != nullptr; }
+
+    void Write(const void* data, size_t size)
+    {
+        const char* bytes = (const char*)data;
+        while (size > 0)
+        {
+            if (used == buffer.size())
+                flush();
+            size_t chunk = std::min(size, buffer.size() - used);
+            memcpy(&buffer[used], bytes, chunk);
+            used += chunk;
+            bytes += chunk;
+            size -= chunk;
+        }
+    }
+
+    // flushes and closes the file, returns false if any write failed
+    bool Close()
+    {
+        if (file)
+        {
+            flush();
+            if (fclose(file) != 0)
+                failed = true;
+            file = nullptr;
+        }
+        return !failed;
+    }
+
+private:
+    FILE* file;
+    std::vector<char> buffer;
+    size_t used = 0;
+    bool failed = false;
+
+    void flush()
+    {
+        if (file && used > 0 && fwrite(&buffer[0], 1, used, file) != used)
+            failed = true;
+        used = 0;
+    }
+};
+
+// the character grid as text, '#' for walls and ' ' for passages, one line per grid row
+inline bool ExportMazeAscii(const Maze& maze, const std::string& path)
+{
+    MazeFileWriter out(path);
+    if (!out.IsOpen())
+        return false;
+    std::vector<uint64_t> row(MazeGridRowWords(maze));
+    std::string line(maze.GridWidth() + 1, '\n');
+    for (int gy = 0; gy < maze.GridHeight(); ++gy)
+    {
+        MazeGridRow(maze, gy, &row[0]);
+        for (int x = 0; x < maze.GridWidth(); ++x)
+            line[x] = ((row[x >> 6] >> (x & 63)) & 1) ? '#' : ' ';
+        out.Write(line.data(), line.size());
+    }
+    return out.Close();
+}
+
+// the grid row as image bytes, most significant bit first, set bits are walls
+inline void mazeRowBytes(const std::vector<uint64_t>& row, unsigned char* bytes, int count, bool invert)
+{
+    static unsigned char reversed[256];
+    static bool ready = false;
+    if (!ready)
+    {
+        for (int i = 0; i < 256; ++i)
+        {
+            int r = 0;
+            for (int b = 0; b < 8; ++b)
+                r |= ((i >> b) & 1) << (7 - b);
+            reversed[i] = (unsigned char)r;
+        }
+        ready = true;
+    }
+    for (int i = 0; i < count; ++i)
+    {
+        unsigned char b = reversed[(row[i >> 3] >> ((i & 7) * 8)) & 0xFF];
+        bytes[i] = invert ? (unsigned char)~b : b;
+    }
+}
+
+// binary PBM (P4), one pixel per grid position, black walls
+inline bool ExportMazePbm(const Maze& maze, const std::string& path)
+{
+    MazeFileWriter out(path);
+    if (!out.IsOpen())
+        return false;
+    std::string header = "P4\n" + std::to_string(maze.GridWidth()) + " " + std::to_string(maze.GridHeight()) + "\n";
+    out.Write(header.data(), header.size());
+    std::vector<uint64_t> row(MazeGridRowWords(maze));
+    int rowBytes = (maze.GridWidth() + 7) / 8;
+    std::vector<unsigned char> bytes(rowBytes);
+    for (int gy = 0; gy < maze.GridHeight(); ++gy)
+    {
+        MazeGridRow(maze, gy, &row[0]);
+        mazeRowBytes(row, &bytes[0], rowBytes, false);
+        out.Write(&bytes[0], rowBytes);
+    }
+    return out.Close();
+}
+
+// PNG chunk checksums
+inline uint32_t mazeCrc32(uint32_t crc, const unsigned char* data, size_t size)
+{
+    static uint32_t table[256];
+    static bool ready = false;
+    if (!ready)
+    {
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[i] = c;
+        }
+        ready = true;
+    }
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+// 1 bit grayscale PNG, one pixel per grid position, black walls.
+// The pixels go into uncompressed deflate blocks so no zlib is needed; the image is only
+// as big as the PBM plus one filter byte per row, use the PBM or binary format to archive.
+class MazePngWriter
+{
+public:
+    MazePngWriter(MazeFileWriter& out) : out(out) {}
+
+    void Write(const Maze& maze)
+    {
+        static const unsigned char signature[8] = { 137, 'P', 'N', 'G', '\r', '\n', 26, '\n' };
+        out.Write(signature, sizeof(signature));
+        unsigned char ihdr[13];
+        putBigEndian(ihdr, (uint32_t)maze.GridWidth());
+        putBigEndian(ihdr + 4, (uint32_t)maze.GridHeight());
+        ihdr[8] = 1;  // bit depth
+        ihdr[9] = 0;  // grayscale
+        ihdr[10] = 0; // deflate
+        ihdr[11] = 0; // adaptive filtering, every row uses filter 0
+        ihdr[12] = 0; // not interlaced
+        chunk("IHDR", ihdr, sizeof(ihdr));
+
+        int rowBytes = (maze.GridWidth() + 7) / 8;
+        remaining = (uint64_t)maze.GridHeight() * (rowBytes + 1);
+        static const unsigned char zlibHeader[2] = { 0x78, 0x01 };
+        idat(zlibHeader, sizeof(zlibHeader));
+
+        std::vector<uint64_t> row(MazeGridRowWords(maze));
+        std::vector<unsigned char> bytes(rowBytes + 1, 0);
+        for (int gy = 0; gy < maze.GridHeight(); ++gy)
+        {
+            MazeGridRow(maze, gy, &row[0]);
+            mazeRowBytes(row, &bytes[1], rowBytes, true);
+            deflate(&bytes[0], bytes.size());
+        }
+        unsigned char adler[4];
+        putBigEndian(adler, (adlerB << 16) | adlerA);
+        idat(adler, sizeof(adler));
+        flushIdat();
+        chunk("IEND", nullptr, 0);
+    }
+
+private:
+    MazeFileWriter& out;
+    std::vector<unsigned char> pending;
+    uint64_t remaining = 0;
+    uint32_t blockLeft = 0;
+    uint32_t adlerA = 1, adlerB = 0;
+
+    static void putBigEndian(unsigned char* p, uint32_t v)
+    {
+        p[0] = (unsigned char)(v >> 24);
+        p[1] = (unsigned char)(v >> 16);
+        p[2] = (unsigned char)(v >> 8);
+        p[3] = (unsigned char)v;
+    }
+
+    void chunk(const char* type, const unsigned char* data, size_t size)
+    {
+        unsigned char length[4];
+        putBigEndian(length, (uint32_t)size);
+        out.Write(length, 4);
+        out.Write(type, 4);
+        if (size > 0)
+            out.Write(data, size);
+        uint32_t crc = mazeCrc32(0, (const unsigned char*)type, 4);
+        crc = mazeCrc32(crc, data, size);
+        unsigned char crcBytes[4];
+        putBigEndian(crcBytes, crc);
+        out.Write(crcBytes, 4);
+    }
+
+    // zlib stream bytes are gathered into IDAT chunks of 1 MB
+    void idat(const unsigned char* data, size_t size)
+    {
+        pending.insert(pending.end(), data, data + size);
+        if (pending.size() >= (1 << 20))
+            flushIdat();
+    }
+
+    void flushIdat()
+    {
+        if (!pending.empty())
+            chunk("IDAT", &pending[0], pending.size());
+        pending.clear();
+    }
+
+    // raw image bytes as stored deflate blocks of at most 65535 bytes
+    void deflate(const unsigned char* data, size_t size)
+    {
+        // adler32, the sums can't overflow for 5552 bytes so the modulo is only taken once per run
+        for (size_t i = 0; i < size;)
+        {
+            size_t end = std::min(size, i + 5552);
+            for (; i < end; ++i)
+            {
+                adlerA += data[i];
+                adlerB += adlerA;
+            }
+            adlerA %= 65521;
+            adlerB %= 65521;
+        }
+        while (size > 0)
+        {
+            if (blockLeft == 0)
+            {
+                blockLeft = (uint32_t)std::min<uint64_t>(remaining, 65535);
+                unsigned char block[5];
+                block[0] = remaining <= 65535 ? 1 : 0;
+                block[1] = (unsigned char)blockLeft;
+                block[2] = (unsigned char)(blockLeft >> 8);
+                block[3] = (unsigned char)~blockLeft;
+                block[4] = (unsigned char)(~blockLeft >> 8);
+                idat(block, sizeof(block));
+            }
+            size_t count = std::min<size_t>(size, blockLeft);
+            idat(data, count);
+            data += count;
+            size -= count;
+            blockLeft -= (uint32_t)count;
+            remaining -= count;
+        }
+    }
+};
+
+inline bool ExportMazePng(const Maze& maze, const std::string& path)
+{
+    MazeFileWriter out(path);
+    if (!out.IsOpen())
+        return false;
+    MazePngWriter png(out);
+    png.Write(maze);
+    return out.Close();
+}
+#endif
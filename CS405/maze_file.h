@@ -0,0 +1,250 @@
+#ifndef MAZE_FILE_H
+#define MAZE_FILE_H
+
+#include "maze.h"
+
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Binary maze file, written once and memory mapped at startup without any parsing.
+//
+//   offset 0            MazeFileHeader (64 bytes)
+//   MetaOffset          MazeFileMeta, only if Flags has MAZE_FILE_HAS_META
+//   WallsOffset         east wall plane then south wall plane, exactly Maze::WallData()
+//
+// Every number is little endian and the wall planes start on a 64 byte boundary, so a
+// mapped file is used by Maze::Wrap() in place and a huge level loads in the time it takes
+// to map it. Files load on any little endian machine, whatever wrote them.
+const char MAZE_FILE_MAGIC[4] = { 'M', 'A', 'Z', 'E' };
+const uint32_t MAZE_FILE_VERSION = 1;
+const uint32_t MAZE_FILE_HAS_META = 1;
+
+struct MazeFileHeader {
+    char Magic[4];
+    uint32_t Version;
+    int32_t Width;
+    int32_t Height;
+    uint64_t Seed;
+    uint32_t WordsPerRow;
+    uint32_t Flags;
+    uint64_t WallsOffset;
+    uint64_t WallsSize;
+    uint64_t MetaOffset;
+    uint32_t MetaSize;
+    uint32_t Reserved;
+};
+
+// precomputed facts about the maze so the game doesn't have to walk it again at load
+struct MazeFileMeta {
+    char Algorithm[32];
+    uint64_t DeadEnds;
+    int32_t StartX, StartY;
+    int32_t ExitX, ExitY;
+    uint8_t Reserved[8];
+};
+
+static_assert(sizeof(MazeFileHeader) == 64, "maze file header must stay 64 bytes");
+static_assert(sizeof(MazeFileMeta) == 64, "maze file metadata must stay 64 bytes");
+
+// fills in the metadata for a maze entered at cell (0,0) and left at the opposite corner
+inline MazeFileMeta MakeMazeFileMeta(const Maze& maze, const char* algorithm)
+{
+    MazeFileMeta meta;
+    memset(&meta, 0, sizeof(meta));
+    strncpy(meta.Algorithm, algorithm, sizeof(meta.Algorithm) - 1);
+    meta.DeadEnds = maze.CountDeadEnds();
+    meta.StartX = 0;
+    meta.StartY = 0;
+    meta.ExitX = maze.Width - 1;
+    meta.ExitY = maze.Height - 1;
+    return meta;
+}
+
+// writes the maze to path, the wall planes go out in a single write straight from memory
+inline bool SaveMazeFile(const std::string& path, const Maze& maze, uint64_t seed, const MazeFileMeta* meta = nullptr)
+{
+    MazeFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.Magic, MAZE_FILE_MAGIC, sizeof(header.Magic));
+    header.Version = MAZE_FILE_VERSION;
+    header.Width = maze.Width;
+    header.Height = maze.Height;
+    header.Seed = seed;
+    header.WordsPerRow = (uint32_t)maze.WordsPerRow();
+    header.Flags = meta ? MAZE_FILE_HAS_META : 0;
+    header.MetaOffset = meta ? sizeof(MazeFileHeader) : 0;
+    header.MetaSize = meta ? sizeof(MazeFileMeta) : 0;
+    header.WallsOffset = sizeof(MazeFileHeader) + header.MetaSize;
+    header.WallsSize = maze.MemoryBytes();
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file)
+    {
+        std::cout << "ERROR::MAZE_FILE::CANNOT_OPEN " << path << std::endl;
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    if (ok && meta)
+        ok = fwrite(meta, sizeof(*meta), 1, file) == 1;
+    if (ok && header.WallsSize > 0)
+        ok = fwrite(maze.WallData(), 1, (size_t)header.WallsSize, file) == header.WallsSize;
+    ok = fclose(file) == 0 && ok;
+    if (!ok)
+        std::cout << "ERROR::MAZE_FILE::WRITE_FAILED " << path << std::endl;
+    return ok;
+}
+
+// true if the wall planes have every wall a Maze keeps standing: the east wall of the last
+// column, the south wall of the last row and the padding bits past Width in both planes.
+// The pathfinders scan whole words and step off the maze if any of them is missing
+inline bool MazeFileBorderIntact(const uint64_t* walls, int width, int height, uint32_t wordsPerRow)
+{
+    if (width == 0 || height == 0)
+        return true;
+    size_t planeWords = (size_t)wordsPerRow * height;
+    size_t last = wordsPerRow - 1;
+    int used = (width - 1) % 64 + 1;
+    // bits from the last column on, and from just past it on
+    uint64_t eastMask = ~0ull << (used - 1);
+    uint64_t southMask = used == 64 ? 0ull : ~0ull << used;
+    for (int y = 0; y < height; ++y)
+    {
+        const uint64_t* east = walls + (size_t)y * wordsPerRow;
+        const uint64_t* south = walls + planeWords + (size_t)y * wordsPerRow;
+        if ((east[last] & eastMask) != eastMask || (south[last] & southMask) != southMask)
+            return false;
+    }
+    const uint64_t* bottom = walls + planeWords + (size_t)(height - 1) * wordsPerRow;
+    for (size_t i = 0; i < wordsPerRow; ++i)
+    {
+        if (bottom[i] != ~0ull)
+            return false;
+    }
+    return true;
+}
+
+// maps path copy-on-write and points maze at the wall bits inside the mapping, the file is
+// never modified even if the maze is carved afterwards. header and meta are filled in if given,
+// meta is zeroed if the file has no metadata.
+inline bool LoadMazeFile(const std::string& path, Maze& maze, MazeFileHeader* header = nullptr, MazeFileMeta* meta = nullptr)
+{
+    const uint32_t endian = 1;
+    if (*(const uint8_t*)&endian != 1)
+    {
+        std::cout << "ERROR::MAZE_FILE::BIG_ENDIAN_HOST_NOT_SUPPORTED" << std::endl;
+        return false;
+    }
+
+    // map the whole file, the shared_ptr unmaps it once the last maze using it is gone
+    std::shared_ptr<void> mapping;
+    uint64_t fileSize = 0;
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+    if (file != INVALID_HANDLE_VALUE)
+    {
+        LARGE_INTEGER size;
+        if (GetFileSizeEx(file, &size) && size.QuadPart >= (LONGLONG)sizeof(MazeFileHeader))
+        {
+            fileSize = (uint64_t)size.QuadPart;
+            HANDLE section = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+            if (section)
+            {
+                void* view = MapViewOfFile(section, FILE_MAP_COPY, 0, 0, 0);
+                if (view)
+                    mapping = std::shared_ptr<void>(view, [](void* p) { UnmapViewOfFile(p); });
+                CloseHandle(section);
+            }
+        }
+        CloseHandle(file);
+    }
+#else
+    int file = open(path.c_str(), O_RDONLY);
+    if (file >= 0)
+    {
+        struct stat info;
+        if (fstat(file, &info) == 0 && info.st_size >= (off_t)sizeof(MazeFileHeader))
+        {
+            fileSize = (uint64_t)info.st_size;
+            void* view = mmap(NULL, (size_t)fileSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+            if (view != MAP_FAILED)
+            {
+                size_t length = (size_t)fileSize;
+                mapping = std::shared_ptr<void>(view, [length](void* p) { munmap(p, length); });
+            }
+        }
+        close(file);
+    }
+#endif
+    if (!mapping)
+    {
+        std::cout << "ERROR::MAZE_FILE::CANNOT_MAP " << path << std::endl;
+        return false;
+    }
+
+    // check the header against the file before trusting any offset in it
+    unsigned char* base = (unsigned char*)mapping.get();
+    MazeFileHeader fileHeader;
+    memcpy(&fileHeader, base, sizeof(fileHeader));
+    if (memcmp(fileHeader.Magic, MAZE_FILE_MAGIC, sizeof(fileHeader.Magic)) != 0)
+    {
+        std::cout << "ERROR::MAZE_FILE::NOT_A_MAZE_FILE " << path << std::endl;
+        return false;
+    }
+    if (fileHeader.Version != MAZE_FILE_VERSION)
+    {
+        std::cout << "ERROR::MAZE_FILE::UNSUPPORTED_VERSION " << fileHeader.Version << " in " << path << std::endl;
+        return false;
+    }
+    uint64_t words = (uint64_t)fileHeader.WordsPerRow * (uint64_t)(fileHeader.Height < 0 ? 0 : fileHeader.Height);
+    bool hasMeta = (fileHeader.Flags & MAZE_FILE_HAS_META) != 0;
+    if (fileHeader.Width < 0 || fileHeader.Height < 0
+        || (uint64_t)fileHeader.Width * (uint64_t)fileHeader.Height > (uint64_t)INT_MAX
+        || fileHeader.WordsPerRow != ((uint64_t)fileHeader.Width + 63) / 64
+        || fileHeader.WallsSize != 2 * words * sizeof(uint64_t)
+        || fileHeader.WallsOffset % sizeof(uint64_t) != 0
+        || fileHeader.WallsOffset > fileSize || fileHeader.WallsSize > fileSize - fileHeader.WallsOffset
+        || (hasMeta && (fileHeader.MetaSize < sizeof(MazeFileMeta) || fileHeader.MetaOffset > fileSize
+            || fileHeader.MetaSize > fileSize - fileHeader.MetaOffset)))
+    {
+        std::cout << "ERROR::MAZE_FILE::CORRUPT_HEADER " << path << std::endl;
+        return false;
+    }
+    // reads the last word of every row, the rest of the walls are only paged in when they're used
+    uint64_t* walls = (uint64_t*)(base + fileHeader.WallsOffset);
+    if (!MazeFileBorderIntact(walls, fileHeader.Width, fileHeader.Height, fileHeader.WordsPerRow))
+    {
+        std::cout << "ERROR::MAZE_FILE::OPEN_BORDER " << path << std::endl;
+        return false;
+    }
+
+    if (header)
+        *header = fileHeader;
+    if (meta)
+    {
+        if (hasMeta)
+            memcpy(meta, base + fileHeader.MetaOffset, sizeof(*meta));
+        else
+            memset(meta, 0, sizeof(*meta));
+        meta->Algorithm[sizeof(meta->Algorithm) - 1] = '\0';
+    }
+    maze.Wrap(fileHeader.Width, fileHeader.Height, walls, mapping);
+    return true;
+}
+#endif
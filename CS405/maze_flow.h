@@ -0,0 +1,208 @@
+#ifndef MAZE_FLOW_H
+#define MAZE_FLOW_H
+
+#include "maze.h"
+
+#include <cstdint>
+#include <vector>
+
+// Flow field towards one target cell (the exit or the player) for any number of agents.
+// One breadth first search from the target stores, for every cell, the direction of the next
+// step towards the target and the distance to it, so an agent only reads its own cell.
+//
+// When the target steps to a neighbouring cell of a perfect maze only the step between the
+// two cells changes direction: every other cell still reaches the new target through the
+// same first step. The distances do all change by one, up on the old target's side and down
+// on the new one's. With the cells numbered in depth first order of the tree the field was
+// built on, one side is a contiguous range of that order, so the change is a range update on
+// a Fenwick tree and a distance read costs O(log cells); no cell is touched. Mazes with loops,
+// jumps of more than one cell and a new Maze::Revision() fall back to a full search.
+class MazeFlowField
+{
+public:
+    // values of Direction() besides the MazeDirections
+    enum { AT_TARGET = 4, UNREACHABLE = 5 };
+
+    int TargetX = -1;
+    int TargetY = -1;
+
+    // searches the whole maze from the target cell (x,y)
+    void Build(const Maze& maze, int x, int y)
+    {
+        width = maze.Width;
+        height = maze.Height;
+        builtRevision = maze.Revision();
+        TargetX = x;
+        TargetY = y;
+        size_t cells = (size_t)width * height;
+        dirs.assign(cells, UNREACHABLE);
+        distances.assign(cells, 0);
+        queue.resize(cells);
+        offset = 0;
+        tree = false;
+        if (!maze.IsInBounds(x, y))
+            return;
+
+        int target = maze.XYToIndex(x, y);
+        dirs[target] = AT_TARGET;
+        size_t head = 0, tail = 0;
+        queue[tail++] = target;
+        size_t openSides = 0;
+        while (head < tail)
+        {
+            int cell = queue[head++];
+            int cx = cell % width, cy = cell / width;
+            for (int dir = 0; dir < 4; ++dir)
+            {
+                if (maze.HasWall(cx, cy, dir))
+                    continue;
+                openSides++;
+                int next = cell + MAZE_DX[dir] + MAZE_DY[dir] * width;
+                if (dirs[next] != UNREACHABLE)
+                    continue;
+                dirs[next] = (uint8_t)((dir + 2) & 3);
+                distances[next] = distances[cell] + 1;
+                queue[tail++] = next;
+            }
+        }
+
+        // the reachable part is a tree if it has one open wall less than cells
+        tree = openSides / 2 == tail - 1;
+        if (tree)
+            numberTree(maze, target);
+    }
+
+    // moves the target to cell (x,y), updating the field in O(log cells) when the target took one
+    // step in a perfect maze and searching again otherwise
+    void MoveTarget(const Maze& maze, int x, int y)
+    {
+        if (x == TargetX && y == TargetY && builtRevision == maze.Revision())
+            return;
+        int dir = stepDirection(x, y);
+        if (!tree || builtRevision != maze.Revision() || maze.Width != width || maze.Height != height
+            || dir < 0 || maze.HasWall(TargetX, TargetY, dir))
+        {
+            Build(maze, x, y);
+            return;
+        }
+        int from = maze.XYToIndex(TargetX, TargetY);
+        int to = maze.XYToIndex(x, y);
+        // the side of the new target is the subtree of whichever of the two cells is deeper in the tree
+        if (distances[to] > distances[from])
+        {
+            offset += 1;
+            addRange(enter[to], leave[to], -2);
+        }
+        else
+        {
+            offset -= 1;
+            addRange(enter[from], leave[from], 2);
+        }
+        dirs[from] = (uint8_t)dir;
+        dirs[to] = AT_TARGET;
+        TargetX = x;
+        TargetY = y;
+    }
+
+    // direction of the next step from cell (x,y) towards the target, AT_TARGET or UNREACHABLE
+    int Direction(int x, int y) const
+    {
+        return dirs[(size_t)y * width + x];
+    }
+
+    // steps from cell (x,y) to the target, -1 if it can't be reached
+    int Distance(int x, int y) const
+    {
+        int cell = y * width + x;
+        if (dirs[cell] == UNREACHABLE)
+            return -1;
+        if (!tree)
+            return (int)distances[cell];
+        return (int)distances[cell] + offset + prefix(enter[cell]);
+    }
+
+    size_t MemoryBytes() const
+    {
+        return dirs.capacity() + (distances.capacity() + enter.capacity() + leave.capacity() + fenwick.capacity() + queue.capacity()) * sizeof(int);
+    }
+
+private:
+    int width = 0, height = 0;
+    uint64_t builtRevision = 0;
+    bool tree = false;
+    std::vector<uint8_t> dirs;
+    // distances from the cell the field was built from, corrected by offset and the Fenwick tree
+    std::vector<uint32_t> distances;
+    int offset = 0;
+    // depth first numbering of the tree, the subtree of a cell is enter[cell] .. leave[cell]
+    std::vector<int> enter;
+    std::vector<int> leave;
+    // range add, point query over the depth first order
+    std::vector<int> fenwick;
+    std::vector<int> queue;
+
+    // direction from the target to cell (x,y), -1 if it isn't a neighbour
+    int stepDirection(int x, int y) const
+    {
+        for (int dir = 0; dir < 4; ++dir)
+        {
+            if (TargetX + MAZE_DX[dir] == x && TargetY + MAZE_DY[dir] == y)
+                return dir;
+        }
+        return -1;
+    }
+
+    // numbers the tree the search found in depth first order, reusing the queue as the stack
+    void numberTree(const Maze& maze, int root)
+    {
+        size_t cells = (size_t)width * height;
+        enter.assign(cells, -1);
+        leave.assign(cells, -1);
+        fenwick.assign(cells + 1, 0);
+        int counter = 0;
+        size_t top = 0;
+        queue[top++] = root;
+        enter[root] = counter++;
+        while (top > 0)
+        {
+            int cell = queue[top - 1];
+            int cx = cell % width, cy = cell / width;
+            // children are the neighbours whose flow leads into this cell
+            bool descended = false;
+            for (int dir = 0; dir < 4 && !descended; ++dir)
+            {
+                if (maze.HasWall(cx, cy, dir))
+                    continue;
+                int next = cell + MAZE_DX[dir] + MAZE_DY[dir] * width;
+                if (enter[next] < 0 && dirs[next] == ((dir + 2) & 3))
+                {
+                    enter[next] = counter++;
+                    queue[top++] = next;
+                    descended = true;
+                }
+            }
+            if (!descended)
+            {
+                leave[cell] = counter - 1;
+                top--;
+            }
+        }
+    }
+
+    void addRange(int from, int to, int value)
+    {
+        for (int i = from + 1; i < (int)fenwick.size(); i += i & -i)
+            fenwick[i] += value;
+        for (int i = to + 2; i < (int)fenwick.size(); i += i & -i)
+            fenwick[i] -= value;
+    }
+
+    int prefix(int position) const
+    {
+        int sum = 0;
+        for (int i = position + 1; i > 0; i -= i & -i)
+            sum += fenwick[i];
+        return sum;
+    }
+};
+#endif
@@ -0,0 +1,353 @@
+#ifndef MAZE_GENERATORS_H
+#define MAZE_GENERATORS_H
+
+#include "maze.h"
+#include "maze_parallel.h"
+#include "random.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// The maze generation algorithms behind the MazeGenerator interface.
+// They all produce perfect mazes but with very different textures: the depth first search
+// makes long winding corridors with few dead ends, Kruskal and Prim make many short dead
+// ends, Wilson is an unbiased sample of all perfect mazes, hunt-and-kill is close to the
+// depth first search and recursive division makes long straight walls.
+
+// randomized depth first search (recursive backtracker), Maze::Generate()
+class BacktrackerGenerator : public MazeGenerator
+{
+public:
+    const char* Name() const override { return "backtracker"; }
+
+    void Generate(Maze& maze, uint64_t seed) override
+    {
+        maze.Reset();
+        scratchBytes = maze.Generate(0, 0, seed);
+    }
+};
+
+// randomized Kruskal: every wall in random order, a wall is knocked down if the cells on
+// both sides are not connected yet according to a union-find over the cells
+class KruskalGenerator : public MazeGenerator
+{
+public:
+    const char* Name() const override { return "kruskal"; }
+
+    void Generate(Maze& maze, uint64_t seed) override
+    {
+        maze.Reset();
+        Random random(seed);
+        int cells = maze.Width * maze.Height;
+        // wall ids are cell * 2 for the east wall and cell * 2 + 1 for the south wall of a cell
+        std::vector<uint32_t> walls;
+        walls.reserve(2 * (size_t)cells);
+        for (int y = 0; y < maze.Height; ++y)
+        {
+            for (int x = 0; x < maze.Width; ++x)
+            {
+                uint32_t cell = (uint32_t)maze.XYToIndex(x, y);
+                if (x + 1 < maze.Width) walls.push_back(cell * 2);
+                if (y + 1 < maze.Height) walls.push_back(cell * 2 + 1);
+            }
+        }
+        if (!walls.empty())
+            random.Shuffle(&walls[0], walls.size());
+
+        std::vector<int> parent(cells);
+        for (int i = 0; i < cells; ++i)
+            parent[i] = i;
+        int joined = 0;
+        for (size_t i = 0; i < walls.size() && joined < cells - 1; ++i)
+        {
+            int cell = (int)(walls[i] >> 1);
+            int dir = (walls[i] & 1) ? SOUTH : EAST;
+            int other = cell + (dir == EAST ? 1 : maze.Width);
+            int a = find(parent, cell);
+            int b = find(parent, other);
+            if (a == b)
+                continue;
+            parent[a] = b;
+            maze.Carve(cell % maze.Width, cell / maze.Width, dir);
+            joined++;
+        }
+        scratchBytes = walls.capacity() * sizeof(uint32_t) + parent.capacity() * sizeof(int);
+    }
+
+private:
+    static int find(std::vector<int>& parent, int i)
+    {
+        while (parent[i] != i)
+        {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    }
+};
+
+// randomized Prim: grows the maze from one cell, every step a random cell on the frontier
+// is joined to a random neighbour that is already part of the maze
+class PrimGenerator : public MazeGenerator
+{
+public:
+    const char* Name() const override { return "prim"; }
+
+    void Generate(Maze& maze, uint64_t seed) override
+    {
+        maze.Reset();
+        Random random(seed);
+        // 0 = not reached yet, 1 = on the frontier, 2 = in the maze
+        std::vector<unsigned char> state((size_t)maze.Width * maze.Height, 0);
+        std::vector<int> frontier;
+        addCell(maze, state, frontier, 0, 0);
+        while (!frontier.empty())
+        {
+            size_t pick = random.NextInt((uint32_t)frontier.size());
+            int cell = frontier[pick];
+            frontier[pick] = frontier.back();
+            frontier.pop_back();
+            int x = cell % maze.Width;
+            int y = cell / maze.Width;
+
+            int dirs[4];
+            int count = 0;
+            for (int dir = 0; dir < 4; ++dir)
+            {
+                int x2 = x + MAZE_DX[dir];
+                int y2 = y + MAZE_DY[dir];
+                if (maze.IsInBounds(x2, y2) && state[maze.XYToIndex(x2, y2)] == 2)
+                    dirs[count++] = dir;
+            }
+            maze.Carve(x, y, dirs[random.NextInt(count)]);
+            addCell(maze, state, frontier, x, y);
+        }
+        scratchBytes = state.capacity() + frontier.capacity() * sizeof(int);
+    }
+
+private:
+    // moves cell (x,y) into the maze and its unreached neighbours onto the frontier
+    static void addCell(const Maze& maze, std::vector<unsigned char>& state, std::vector<int>& frontier, int x, int y)
+    {
+        state[maze.XYToIndex(x, y)] = 2;
+        for (int dir = 0; dir < 4; ++dir)
+        {
+            int x2 = x + MAZE_DX[dir];
+            int y2 = y + MAZE_DY[dir];
+            if (maze.IsInBounds(x2, y2) && state[maze.XYToIndex(x2, y2)] == 0)
+            {
+                state[maze.XYToIndex(x2, y2)] = 1;
+                frontier.push_back(maze.XYToIndex(x2, y2));
+            }
+        }
+    }
+};
+
+// Wilson: loop-erased random walks from every cell not in the maze yet until the walk hits
+// the maze, the walk only remembers the last direction it left each cell so loops erase themselves
+class WilsonGenerator : public MazeGenerator
+{
+public:
+    const char* Name() const override { return "wilson"; }
+
+    void Generate(Maze& maze, uint64_t seed) override
+    {
+        maze.Reset();
+        Random random(seed);
+        int cells = maze.Width * maze.Height;
+        std::vector<unsigned char> inMaze(cells, 0);
+        std::vector<unsigned char> walk(cells, 0);
+        inMaze[random.NextInt(cells)] = 1;
+        for (int start = 0; start < cells; ++start)
+        {
+            if (inMaze[start])
+                continue;
+            // random walk until the maze is hit
+            int x = start % maze.Width;
+            int y = start / maze.Width;
+            while (!inMaze[maze.XYToIndex(x, y)])
+            {
+                int dir;
+                do
+                {
+                    dir = random.NextInt(4);
+                } while (!maze.IsInBounds(x + MAZE_DX[dir], y + MAZE_DY[dir]));
+                walk[maze.XYToIndex(x, y)] = (unsigned char)dir;
+                x += MAZE_DX[dir];
+                y += MAZE_DY[dir];
+            }
+            // follow the loop-erased walk again and carve it into the maze
+            x = start % maze.Width;
+            y = start / maze.Width;
+            while (!inMaze[maze.XYToIndex(x, y)])
+            {
+                int dir = walk[maze.XYToIndex(x, y)];
+                inMaze[maze.XYToIndex(x, y)] = 1;
+                maze.Carve(x, y, dir);
+                x += MAZE_DX[dir];
+                y += MAZE_DY[dir];
+            }
+        }
+        scratchBytes = inMaze.capacity() + walk.capacity();
+    }
+};
+
+// hunt-and-kill: random walk until stuck, then hunt for the first cell not in the maze yet.
+// Cells are visited in row order by the hunt, so the first unvisited cell always has a visited
+// neighbour to its north or west, and the hunt is a bit scan over the packed visited rows that
+// never looks at a finished word twice.
+class HuntAndKillGenerator : public MazeGenerator
+{
+public:
+    const char* Name() const override { return "huntandkill"; }
+
+    void Generate(Maze& maze, uint64_t seed) override
+    {
+        maze.Reset();
+        Random random(seed);
+        int words = maze.WordsPerRow();
+        // visited bits, padding bits past the last column count as visited
+        std::vector<uint64_t> visited((size_t)words * maze.Height, 0);
+        if (maze.Width & 63)
+        {
+            for (int y = 0; y < maze.Height; ++y)
+                visited[(size_t)y * words + words - 1] = ~0ull << (maze.Width & 63);
+        }
+        auto isVisited = [&](int x, int y) {
+            return (visited[(size_t)y * words + (x >> 6)] >> (x & 63)) & 1;
+        };
+        auto visit = [&](int x, int y) {
+            visited[(size_t)y * words + (x >> 6)] |= 1ull << (x & 63);
+        };
+
+        size_t hunt = 0;
+        int x = 0, y = 0;
+        visit(x, y);
+        while (true)
+        {
+            // kill: walk to a random unvisited neighbour
+            int dirs[4];
+            int count = 0;
+            for (int dir = 0; dir < 4; ++dir)
+            {
+                int x2 = x + MAZE_DX[dir];
+                int y2 = y + MAZE_DY[dir];
+                if (maze.IsInBounds(x2, y2) && !isVisited(x2, y2))
+                    dirs[count++] = dir;
+            }
+            if (count > 0)
+            {
+                int dir = dirs[random.NextInt(count)];
+                maze.Carve(x, y, dir);
+                x += MAZE_DX[dir];
+                y += MAZE_DY[dir];
+                visit(x, y);
+                continue;
+            }
+
+            // hunt: first word with a zero bit, then its lowest zero bit
+            while (hunt < visited.size() && visited[hunt] == ~0ull)
+                hunt++;
+            if (hunt == visited.size())
+                break;
+            y = (int)(hunt / words);
+            x = (int)(hunt % words) * 64 + lowestBit(~visited[hunt]);
+            count = 0;
+            for (int dir = 0; dir < 4; ++dir)
+            {
+                int x2 = x + MAZE_DX[dir];
+                int y2 = y + MAZE_DY[dir];
+                if (maze.IsInBounds(x2, y2) && isVisited(x2, y2))
+                    dirs[count++] = dir;
+            }
+            maze.Carve(x, y, dirs[random.NextInt(count)]);
+            visit(x, y);
+        }
+        scratchBytes = visited.capacity() * sizeof(uint64_t);
+    }
+};
+
+// recursive division: starts from an empty room and keeps splitting chambers with a wall
+// that has a single gap. The chambers still to split are kept on a heap allocated stack.
+class RecursiveDivisionGenerator : public MazeGenerator
+{
+public:
+    const char* Name() const override { return "division"; }
+
+    void Generate(Maze& maze, uint64_t seed) override
+    {
+        maze.Reset();
+        maze.OpenAll();
+        Random random(seed);
+        std::vector<Chamber> chambers;
+        size_t peak = 0;
+        chambers.push_back(Chamber(0, 0, maze.Width, maze.Height));
+        while (!chambers.empty())
+        {
+            Chamber c = chambers.back();
+            chambers.pop_back();
+            if (c.W < 2 && c.H < 2)
+                continue;
+            bool horizontal = c.H > c.W || (c.H == c.W && (random.Next() & 1));
+            if (c.W < 2) horizontal = true;
+            if (c.H < 2) horizontal = false;
+            if (horizontal)
+            {
+                // wall on the south side of row wy, with one gap
+                int wy = c.Y + (int)random.NextInt(c.H - 1);
+                int gap = c.X + (int)random.NextInt(c.W);
+                for (int x = c.X; x < c.X + c.W; ++x)
+                {
+                    if (x != gap)
+                        maze.AddWall(x, wy, SOUTH);
+                }
+                chambers.push_back(Chamber(c.X, c.Y, c.W, wy - c.Y + 1));
+                chambers.push_back(Chamber(c.X, wy + 1, c.W, c.Y + c.H - wy - 1));
+            }
+            else
+            {
+                // wall on the east side of column wx, with one gap
+                int wx = c.X + (int)random.NextInt(c.W - 1);
+                int gap = c.Y + (int)random.NextInt(c.H);
+                for (int y = c.Y; y < c.Y + c.H; ++y)
+                {
+                    if (y != gap)
+                        maze.AddWall(wx, y, EAST);
+                }
+                chambers.push_back(Chamber(c.X, c.Y, wx - c.X + 1, c.H));
+                chambers.push_back(Chamber(wx + 1, c.Y, c.X + c.W - wx - 1, c.H));
+            }
+            if (chambers.size() > peak)
+                peak = chambers.size();
+        }
+        scratchBytes = peak * sizeof(Chamber);
+    }
+
+private:
+    struct Chamber {
+        int X, Y, W, H;
+        Chamber(int x, int y, int w, int h) : X(x), Y(y), W(w), H(h) {}
+    };
+};
+
+// names accepted by CreateMazeGenerator()
+inline std::vector<std::string> MazeGeneratorNames()
+{
+    return { "backtracker", "tiled", "kruskal", "prim", "wilson", "huntandkill", "division" };
+}
+
+// creates the generator with the given name, or nullptr if there is none
+inline std::unique_ptr<MazeGenerator> CreateMazeGenerator(const std::string& name)
+{
+    if (name == "backtracker") return std::unique_ptr<MazeGenerator>(new BacktrackerGenerator());
+    if (name == "tiled") return std::unique_ptr<MazeGenerator>(new TiledMazeGenerator());
+    if (name == "kruskal") return std::unique_ptr<MazeGenerator>(new KruskalGenerator());
+    if (name == "prim") return std::unique_ptr<MazeGenerator>(new PrimGenerator());
+    if (name == "wilson") return std::unique_ptr<MazeGenerator>(new WilsonGenerator());
+    if (name == "huntandkill") return std::unique_ptr<MazeGenerator>(new HuntAndKillGenerator());
+    if (name == "division") return std::unique_ptr<MazeGenerator>(new RecursiveDivisionGenerator());
+    return nullptr;
+}
+#endif
@@ -0,0 +1,374 @@
+#ifndef MAZE_GRAPH_H
+#define MAZE_GRAPH_H
+
+#include "maze.h"
+#include "maze_path.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// The maze with its corridors collapsed.
+// Every cell that isn't a corridor cell (open on exactly two sides) is a node: junctions,
+// dead ends and, in mazes with loops, one cell of any loop that has no junction on it. The
+// corridors between them become weighted edges, the weight being the number of steps. The
+// graph is stored compressed (CSR): the edges of node n are Targets/Weights/Dirs[Offsets[n]
+// .. Offsets[n + 1]), Dirs holding the direction the corridor leaves the node in, so a
+// corridor can be walked again to get its cells back. Nodes are numbered in cell order,
+// which makes finding the node of a cell a binary search and no per cell table is kept.
+class MazeGraph
+{
+public:
+    // cell of every node, increasing
+    std::vector<int> Cells;
+    std::vector<int> Offsets;
+    std::vector<int> Targets;
+    std::vector<uint32_t> Weights;
+    std::vector<uint8_t> Dirs;
+
+    int NodeCount() const { return (int)Cells.size(); }
+    int EdgeCount() const { return (int)Targets.size(); }
+
+    size_t MemoryBytes() const
+    {
+        return Cells.capacity() * sizeof(int) + Offsets.capacity() * sizeof(int) + Targets.capacity() * sizeof(int)
+            + Weights.capacity() * sizeof(uint32_t) + Dirs.capacity() + loopNodes.capacity() * sizeof(int);
+    }
+
+    // node of a cell, -1 for corridor cells
+    int NodeOf(int cell) const
+    {
+        std::vector<int>::const_iterator it = std::lower_bound(Cells.begin(), Cells.end(), cell);
+        return it != Cells.end() && *it == cell ? (int)(it - Cells.begin()) : -1;
+    }
+
+    // number of open sides of cell (x,y)
+    static int Degree(const Maze& maze, int x, int y)
+    {
+        return countWays(maze.OpenDirections(x, y));
+    }
+
+    // walks from cell (x,y) through its open side dir and along the corridor until it gets to a
+    // node (or back to the cell it started from). visit(cell) is called for every cell stepped
+    // on, the last one included, and can stop the walk early by returning false. x, y and dir are
+    // left at the last cell and the direction of the last step, returns the number of steps.
+    template <typename Visit>
+    int Follow(const Maze& maze, int& x, int& y, int& dir, Visit visit) const
+    {
+        int startX = x, startY = y;
+        int steps = 0;
+        while (true)
+        {
+            x += MAZE_DX[dir];
+            y += MAZE_DY[dir];
+            steps++;
+            if (!visit(maze.XYToIndex(x, y)) || (x == startX && y == startY))
+                return steps;
+            int ways = maze.OpenDirections(x, y);
+            if (countWays(ways) != 2 || isLoopNode(maze.XYToIndex(x, y)))
+                return steps;
+            dir = firstDir(ways & ~(1 << ((dir + 2) & 3)));
+        }
+    }
+
+    // builds the graph of the maze
+    void Build(const Maze& maze)
+    {
+        Cells.clear();
+        loopNodes.clear();
+        for (int y = 0; y < maze.Height; ++y)
+        {
+            for (int x = 0; x < maze.Width; ++x)
+            {
+                if (Degree(maze, x, y) != 2)
+                    Cells.push_back(maze.XYToIndex(x, y));
+            }
+        }
+
+        // corridors that close into a loop without passing a node get a node of their own,
+        // found as the corridor cells no walk from a node reaches
+        std::vector<uint64_t> reached(((size_t)maze.Width * maze.Height + 63) / 64, 0);
+        auto mark = [&](int cell) { reached[cell >> 6] |= 1ull << (cell & 63); return true; };
+        for (size_t n = 0; n < Cells.size(); ++n)
+        {
+            mark(Cells[n]);
+            walkAll(maze, (int)n, [&](int, int, int) {}, mark);
+        }
+        for (int cell = 0; cell < maze.Width * maze.Height; ++cell)
+        {
+            if ((reached[cell >> 6] >> (cell & 63)) & 1)
+                continue;
+            // the whole loop is reached from its new node
+            loopNodes.push_back(cell);
+            Cells.insert(std::lower_bound(Cells.begin(), Cells.end(), cell), cell);
+            int x = cell % maze.Width, y = cell / maze.Width;
+            int dir = firstDir(maze.OpenDirections(x, y));
+            mark(cell);
+            Follow(maze, x, y, dir, mark);
+        }
+
+        Offsets.assign(1, 0);
+        Targets.clear();
+        Weights.clear();
+        Dirs.clear();
+        for (size_t n = 0; n < Cells.size(); ++n)
+        {
+            walkAll(maze, (int)n, [&](int dir, int end, int steps) {
+                Targets.push_back(NodeOf(end));
+                Weights.push_back((uint32_t)steps);
+                Dirs.push_back((uint8_t)dir);
+            }, [](int) { return true; });
+            Offsets.push_back((int)Targets.size());
+        }
+    }
+
+private:
+    // corridor cells that were made nodes because their loop has no other, increasing
+    std::vector<int> loopNodes;
+
+    bool isLoopNode(int cell) const
+    {
+        return !loopNodes.empty() && std::binary_search(loopNodes.begin(), loopNodes.end(), cell);
+    }
+
+    static int countWays(int ways)
+    {
+        return (ways & 1) + ((ways >> 1) & 1) + ((ways >> 2) & 1) + ((ways >> 3) & 1);
+    }
+
+    static int firstDir(int ways)
+    {
+        return ways & 1 ? NORTH : ways & 2 ? EAST : ways & 4 ? SOUTH : WEST;
+    }
+
+    // follows every corridor out of node n, edge(dir, endCell, steps) is called once per corridor
+    template <typename Edge, typename Visit>
+    void walkAll(const Maze& maze, int n, Edge edge, Visit visit) const
+    {
+        int cell = Cells[n];
+        for (int dir = 0; dir < 4; ++dir)
+        {
+            int x = cell % maze.Width, y = cell / maze.Width;
+            if (maze.HasWall(x, y, dir))
+                continue;
+            int d = dir;
+            int steps = Follow(maze, x, y, d, visit);
+            edge(dir, maze.XYToIndex(x, y), steps);
+        }
+    }
+};
+
+// Pathfinding on the junction graph of the maze.
+// A* runs over the nodes only, start and goal cells inside a corridor are linked to the two
+// nodes at the ends of their corridor, and the corridors of the result are walked again to
+// hand back the cells. The graph is rebuilt when the maze changes (Maze::Revision()).
+class JunctionGraphPathFinder : public PathFinder
+{
+public:
+    const char* Name() const override { return "graph"; }
+
+    // the graph of the maze of the last query, e.g. for AI decisions at junctions
+    const MazeGraph& Graph() const { return graph; }
+
+    bool FindPath(const Maze& maze, int startX, int startY, int goalX, int goalY, std::vector<int>& path) override
+    {
+        path.clear();
+        expanded = 0;
+        if (!maze.IsInBounds(startX, startY) || !maze.IsInBounds(goalX, goalY))
+            return false;
+        if (builtRevision != maze.Revision())
+        {
+            graph.Build(maze);
+            builtRevision = maze.Revision();
+        }
+        int start = maze.XYToIndex(startX, startY);
+        int goal = maze.XYToIndex(goalX, goalY);
+        int goalNode = graph.NodeCount();
+        scratch.Begin((size_t)goalNode + 1);
+
+        // the nodes the start and goal are on or between, a goal on the start's own corridor is reached directly
+        direct.Steps = UINT32_MAX;
+        startEnds = locate(maze, start, startLinks, goal, &direct);
+        goalEnds = locate(maze, goal, goalLinks, -1, nullptr);
+        if (direct.Steps != UINT32_MAX && scratch.Relax(goalNode, direct.Steps, goalNode))
+            scratch.Push(goalNode, direct.Steps);
+        for (int i = 0; i < startEnds; ++i)
+        {
+            const Link& link = startLinks[i];
+            if (scratch.Relax(link.Node, link.Steps, link.Node))
+                scratch.Push(link.Node, link.Steps + heuristic(maze, graph.Cells[link.Node], goalX, goalY));
+        }
+
+        while (!scratch.Empty())
+        {
+            int node = scratch.Pop();
+            if (!scratch.Close(node))
+                continue;
+            expanded++;
+            if (node == goalNode)
+                break;
+            uint32_t g = scratch.G(node);
+            for (int e = graph.Offsets[node]; e < graph.Offsets[node + 1]; ++e)
+            {
+                int next = graph.Targets[e];
+                if (scratch.Relax(next, g + graph.Weights[e], node))
+                    scratch.Push(next, g + graph.Weights[e] + heuristic(maze, graph.Cells[next], goalX, goalY));
+            }
+            for (int i = 0; i < goalEnds; ++i)
+            {
+                if (goalLinks[i].Node == node && scratch.Relax(goalNode, g + goalLinks[i].Steps, node))
+                    scratch.Push(goalNode, g + goalLinks[i].Steps);
+            }
+        }
+
+        bool found = scratch.IsClosed(goalNode);
+        if (found)
+            expand(maze, start, goal, goalNode, path);
+        scratch.End();
+        scratchBytes = scratch.Bytes() + graph.MemoryBytes();
+        return found;
+    }
+
+private:
+    // a cell's way to a node: the node, the steps to it and the direction the cell is left in
+    struct Link {
+        int Node;
+        uint32_t Steps;
+        int Dir;
+    };
+
+    MazeGraph graph;
+    uint64_t builtRevision = 0;
+    PathScratch scratch;
+    Link startLinks[4];
+    Link goalLinks[4];
+    int startEnds = 0, goalEnds = 0;
+    // the way from the start to a goal on its own corridor
+    Link direct;
+    std::vector<int> route;
+
+    static uint32_t heuristic(const Maze& maze, int cell, int goalX, int goalY)
+    {
+        return MazeManhattan(cell % maze.Width, cell / maze.Width, goalX, goalY);
+    }
+
+    // fills links with the nodes cell is on or between and returns how many there are. If
+    // target is met on the way, the shortest way to it goes to *toTarget.
+    int locate(const Maze& maze, int cell, Link* links, int target, Link* toTarget)
+    {
+        if (cell == target)
+        {
+            toTarget->Steps = 0;
+            toTarget->Dir = -1;
+        }
+        int node = graph.NodeOf(cell);
+        if (node >= 0)
+        {
+            links[0].Node = node;
+            links[0].Steps = 0;
+            links[0].Dir = -1;
+            return 1;
+        }
+        int count = 0;
+        int x0 = cell % maze.Width, y0 = cell / maze.Width;
+        for (int dir = 0; dir < 4; ++dir)
+        {
+            if (maze.HasWall(x0, y0, dir))
+                continue;
+            int x = x0, y = y0, d = dir;
+            uint32_t steps = 0;
+            graph.Follow(maze, x, y, d, [&](int at) {
+                steps++;
+                if (at == target && steps < toTarget->Steps)
+                {
+                    toTarget->Steps = steps;
+                    toTarget->Dir = dir;
+                }
+                return true;
+            });
+            links[count].Node = graph.NodeOf(maze.XYToIndex(x, y));
+            links[count].Steps = steps;
+            links[count].Dir = dir;
+            count++;
+        }
+        return count;
+    }
+
+    // appends the cells after (x,y) along the corridor leaving it in direction dir, up to and including the cell at steps
+    void walk(const Maze& maze, int cell, int dir, uint32_t steps, std::vector<int>& path)
+    {
+        int x = cell % maze.Width, y = cell / maze.Width, d = dir;
+        uint32_t taken = 0;
+        graph.Follow(maze, x, y, d, [&](int at) {
+            path.push_back(at);
+            return ++taken < steps;
+        });
+    }
+
+    // turns the chain of nodes of the search into cells
+    void expand(const Maze& maze, int start, int goal, int goalNode, std::vector<int>& path)
+    {
+        path.push_back(start);
+        int last = scratch.Parent(goalNode);
+        if (last == goalNode)
+        {
+            if (direct.Dir >= 0)
+                walk(maze, start, direct.Dir, direct.Steps, path);
+            return;
+        }
+
+        route.clear();
+        for (int node = last;; node = scratch.Parent(node))
+        {
+            route.push_back(node);
+            if (scratch.Parent(node) == node)
+                break;
+        }
+        std::reverse(route.begin(), route.end());
+
+        // start to the first node
+        for (int i = 0; i < startEnds; ++i)
+        {
+            const Link& link = startLinks[i];
+            if (link.Node == route[0] && scratch.G(route[0]) == link.Steps)
+            {
+                if (link.Dir >= 0)
+                    walk(maze, start, link.Dir, link.Steps, path);
+                break;
+            }
+        }
+        // node to node along the shortest edge between them
+        for (size_t k = 1; k < route.size(); ++k)
+        {
+            int from = route[k - 1];
+            uint32_t best = UINT32_MAX;
+            int bestEdge = -1;
+            for (int e = graph.Offsets[from]; e < graph.Offsets[from + 1]; ++e)
+            {
+                if (graph.Targets[e] == route[k] && graph.Weights[e] < best)
+                {
+                    best = graph.Weights[e];
+                    bestEdge = e;
+                }
+            }
+            walk(maze, graph.Cells[from], graph.Dirs[bestEdge], best, path);
+        }
+        // last node to the goal, walked from the goal and turned around
+        for (int i = 0; i < goalEnds; ++i)
+        {
+            const Link& link = goalLinks[i];
+            if (link.Node == last && scratch.G(last) + link.Steps == scratch.G(goalNode))
+            {
+                if (link.Dir < 0)
+                    break;
+                size_t end = path.size();
+                path.push_back(goal);
+                walk(maze, goal, link.Dir, link.Steps, path);
+                path.pop_back();
+                std::reverse(path.begin() + end, path.end());
+                break;
+            }
+        }
+    }
+};
+#endif
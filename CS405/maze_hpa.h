@@ -0,0 +1,353 @@
+#ifndef MAZE_HPA_H
+#define MAZE_HPA_H
+
+#include "maze.h"
+#include "maze_path.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Hierarchical pathfinding (HPA*) for large mazes.
+// The maze is cut into square clusters. Every open wall on the border between two clusters
+// is an entrance with a node on each side, and every cluster knows the distance between each
+// pair of its own nodes, found once with a search that stays inside the cluster. A query
+// runs A* over those nodes only (one step across an entrance, the stored distance inside a
+// cluster) and then refines the few cluster crossings it picked into cells, again without
+// leaving a cluster. Since every entrance is a node and the stored distances are exact, the
+// paths are as short as the ones A* finds.
+//
+// The nodes of a cluster are listed side by side (north, east, south, west), each side in
+// increasing x or y, so the k-th node on the east side of a cluster and the k-th node on the
+// west side of its neighbour are the two ends of the same entrance and no links between
+// clusters have to be stored. That way one cluster can be rebuilt without touching the others:
+// walls changed with SetWall() only mark their one or two clusters dirty, and those are rebuilt
+// on the next query. Any other change to the maze (a new Maze::Revision()) rebuilds them all.
+class HierarchicalPathFinder : public PathFinder
+{
+public:
+    // cluster size in cells, at most 255 so distances inside a cluster fit 16 bits
+    int ClusterSize;
+
+    HierarchicalPathFinder(int clusterSize = 32) : ClusterSize(std::max(2, std::min(255, clusterSize)))
+    {
+    }
+
+    const char* Name() const override { return "hpa"; }
+
+    // changes a wall like Maze::SetWall() and marks the clusters on both sides of it for rebuilding
+    void SetWall(Maze& maze, int x, int y, int dir, bool wall)
+    {
+        // walls of the outer border and of cells outside the maze are left alone, like Maze::SetWall() does
+        if (!maze.IsInBounds(x, y) || !maze.IsInBounds(x + MAZE_DX[dir], y + MAZE_DY[dir]))
+            return;
+        bool current = builtRevision == maze.Revision();
+        maze.SetWall(x, y, dir, wall);
+        if (!current || clusters.empty() || builtClusterSize != ClusterSize)
+            return;
+        builtRevision = maze.Revision();
+        markDirty(x, y);
+        markDirty(x + MAZE_DX[dir], y + MAZE_DY[dir]);
+    }
+
+    // clusters rebuilt by the last query
+    size_t Rebuilt() const { return rebuilt; }
+
+    bool FindPath(const Maze& maze, int startX, int startY, int goalX, int goalY, std::vector<int>& path) override
+    {
+        path.clear();
+        expanded = 0;
+        if (!maze.IsInBounds(startX, startY) || !maze.IsInBounds(goalX, goalY))
+            return false;
+        update(maze);
+        int start = maze.XYToIndex(startX, startY);
+        int goal = maze.XYToIndex(goalX, goalY);
+        int startCluster = clusterOf(startX, startY);
+        int goalCluster = clusterOf(goalX, goalY);
+        // node id past every cluster node that stands for the goal cell
+        int goalNode = (int)clusters.size() * maxNodes;
+        scratch.Begin((size_t)goalNode + 1);
+
+        // the distances from the start and to the goal inside their clusters link them to the graph
+        localSearch(maze, startCluster, start, -1);
+        const Cluster& from = clusters[startCluster];
+        for (size_t i = 0; i < from.Nodes.size(); ++i)
+        {
+            int distance = localDistance(from.Nodes[i]);
+            int node = startCluster * maxNodes + (int)i;
+            if (distance >= 0 && scratch.Relax(node, distance, node))
+                scratch.Push(node, distance + heuristic(maze, from.Nodes[i], goalX, goalY));
+        }
+        if (startCluster == goalCluster && localDistance(goal) >= 0 && scratch.Relax(goalNode, localDistance(goal), goalNode))
+            scratch.Push(goalNode, localDistance(goal));
+        localSearch(maze, goalCluster, goal, -1);
+        goalDistance.assign(clusters[goalCluster].Nodes.size(), -1);
+        for (size_t i = 0; i < goalDistance.size(); ++i)
+            goalDistance[i] = localDistance(clusters[goalCluster].Nodes[i]);
+
+        // A* over the entrances
+        while (!scratch.Empty())
+        {
+            int node = scratch.Pop();
+            if (!scratch.Close(node))
+                continue;
+            expanded++;
+            if (node == goalNode)
+                break;
+            int c = node / maxNodes;
+            int i = node % maxNodes;
+            const Cluster& cluster = clusters[c];
+            int count = (int)cluster.Nodes.size();
+            uint32_t g = scratch.G(node);
+            relax(maze, partner(c, i), g + 1, node, goalX, goalY);
+            for (int j = 0; j < count; ++j)
+            {
+                uint16_t distance = cluster.Distances[(size_t)i * count + j];
+                if (j != i && distance != UNREACHABLE)
+                    relax(maze, c * maxNodes + j, g + distance, node, goalX, goalY);
+            }
+            if (c == goalCluster && goalDistance[i] >= 0 && scratch.Relax(goalNode, g + goalDistance[i], node))
+                scratch.Push(goalNode, g + goalDistance[i]);
+        }
+
+        bool found = scratch.IsClosed(goalNode);
+        if (found)
+        {
+            // the chain of entrances back to the start, then refined cluster by cluster
+            route.clear();
+            for (int node = scratch.Parent(goalNode); node != goalNode; node = scratch.Parent(node))
+            {
+                route.push_back(node);
+                if (scratch.Parent(node) == node)
+                    break;
+            }
+            std::reverse(route.begin(), route.end());
+            path.push_back(start);
+            int at = start;
+            for (size_t k = 0; k < route.size(); ++k)
+            {
+                int c = route[k] / maxNodes;
+                int cell = clusters[c].Nodes[route[k] % maxNodes];
+                if (k > 0 && route[k - 1] / maxNodes != c)
+                    path.push_back(cell);
+                else
+                    appendLocalPath(maze, c, at, cell, path);
+                at = cell;
+            }
+            appendLocalPath(maze, goalCluster, at, goal, path);
+        }
+        scratch.End();
+        scratchBytes = scratch.Bytes() + local.size() * (sizeof(int) + sizeof(uint32_t) + 1) + graphBytes;
+        return found;
+    }
+
+private:
+    struct Cluster {
+        // cells of the entrance nodes, side by side in the order north, east, south, west
+        std::vector<int> Nodes;
+        int SideStart[5];
+        // Nodes.size() squared distances between the nodes inside the cluster
+        std::vector<uint16_t> Distances;
+        bool Dirty = true;
+    };
+
+    enum { UNREACHABLE = 0xFFFF };
+
+    std::vector<Cluster> clusters;
+    int clustersX = 0, clustersY = 0;
+    int maxNodes = 0;
+    int builtWidth = -1, builtHeight = -1, builtClusterSize = 0;
+    uint64_t builtRevision = 0;
+    size_t rebuilt = 0;
+    size_t graphBytes = 0;
+    PathScratch scratch;
+    std::vector<int> goalDistance;
+    std::vector<int> route;
+
+    // breadth first search inside one cluster, indexed by the cell's position in the cluster
+    std::vector<int> local;
+    std::vector<uint32_t> localStamp;
+    std::vector<uint8_t> localDir;
+    std::vector<int> queue;
+    uint32_t localQuery = 0;
+    int localX0 = 0, localY0 = 0, localWidth = 0, localHeight = 0;
+
+    int clusterOf(int x, int y) const
+    {
+        return (y / ClusterSize) * clustersX + x / ClusterSize;
+    }
+
+    void markDirty(int x, int y)
+    {
+        clusters[clusterOf(x, y)].Dirty = true;
+    }
+
+    static uint32_t heuristic(const Maze& maze, int cell, int goalX, int goalY)
+    {
+        return MazeManhattan(cell % maze.Width, cell / maze.Width, goalX, goalY);
+    }
+
+    void relax(const Maze& maze, int node, uint32_t g, int from, int goalX, int goalY)
+    {
+        if (scratch.Relax(node, g, from))
+            scratch.Push(node, g + heuristic(maze, clusters[node / maxNodes].Nodes[node % maxNodes], goalX, goalY));
+    }
+
+    // the node at the other end of the entrance of node i of cluster c
+    int partner(int c, int i) const
+    {
+        const Cluster& cluster = clusters[c];
+        int side = 0;
+        while (i >= cluster.SideStart[side + 1])
+            side++;
+        int next = c + (side == EAST ? 1 : side == WEST ? -1 : side == SOUTH ? clustersX : -clustersX);
+        return next * maxNodes + clusters[next].SideStart[(side + 2) & 3] + (i - cluster.SideStart[side]);
+    }
+
+    // rebuilds the clusters that changed since the last query
+    void update(const Maze& maze)
+    {
+        rebuilt = 0;
+        if (builtWidth != maze.Width || builtHeight != maze.Height || builtClusterSize != ClusterSize)
+        {
+            builtWidth = maze.Width;
+            builtHeight = maze.Height;
+            builtClusterSize = ClusterSize;
+            clustersX = (maze.Width + ClusterSize - 1) / ClusterSize;
+            clustersY = (maze.Height + ClusterSize - 1) / ClusterSize;
+            maxNodes = 4 * ClusterSize;
+            clusters.assign((size_t)clustersX * clustersY, Cluster());
+            local.resize((size_t)ClusterSize * ClusterSize);
+            localStamp.assign(local.size(), 0);
+            localDir.resize(local.size());
+            queue.resize(local.size());
+            builtRevision = 0;
+        }
+        if (builtRevision != maze.Revision())
+        {
+            for (size_t c = 0; c < clusters.size(); ++c)
+                clusters[c].Dirty = true;
+            builtRevision = maze.Revision();
+        }
+        for (size_t c = 0; c < clusters.size(); ++c)
+        {
+            if (clusters[c].Dirty)
+                build(maze, (int)c);
+        }
+        if (rebuilt > 0)
+        {
+            graphBytes = clusters.capacity() * sizeof(Cluster);
+            for (size_t c = 0; c < clusters.size(); ++c)
+                graphBytes += clusters[c].Nodes.capacity() * sizeof(int) + clusters[c].Distances.capacity() * sizeof(uint16_t);
+        }
+    }
+
+    // finds the entrances of cluster c and the distances between them
+    void build(const Maze& maze, int c)
+    {
+        Cluster& cluster = clusters[c];
+        int x0 = (c % clustersX) * ClusterSize, y0 = (c / clustersX) * ClusterSize;
+        int x1 = std::min(x0 + ClusterSize, maze.Width), y1 = std::min(y0 + ClusterSize, maze.Height);
+        cluster.Nodes.clear();
+        cluster.SideStart[NORTH] = 0;
+        for (int x = x0; y0 > 0 && x < x1; ++x)
+            if (!maze.HasWall(x, y0, NORTH)) cluster.Nodes.push_back(maze.XYToIndex(x, y0));
+        cluster.SideStart[EAST] = (int)cluster.Nodes.size();
+        for (int y = y0; x1 < maze.Width && y < y1; ++y)
+            if (!maze.HasWall(x1 - 1, y, EAST)) cluster.Nodes.push_back(maze.XYToIndex(x1 - 1, y));
+        cluster.SideStart[SOUTH] = (int)cluster.Nodes.size();
+        for (int x = x0; y1 < maze.Height && x < x1; ++x)
+            if (!maze.HasWall(x, y1 - 1, SOUTH)) cluster.Nodes.push_back(maze.XYToIndex(x, y1 - 1));
+        cluster.SideStart[WEST] = (int)cluster.Nodes.size();
+        for (int y = y0; x0 > 0 && y < y1; ++y)
+            if (!maze.HasWall(x0, y, WEST)) cluster.Nodes.push_back(maze.XYToIndex(x0, y));
+        cluster.SideStart[4] = (int)cluster.Nodes.size();
+
+        int count = (int)cluster.Nodes.size();
+        cluster.Distances.assign((size_t)count * count, (uint16_t)UNREACHABLE);
+        for (int i = 0; i < count; ++i)
+        {
+            localSearch(maze, c, cluster.Nodes[i], -1);
+            for (int j = 0; j < count; ++j)
+            {
+                int distance = localDistance(cluster.Nodes[j]);
+                if (distance >= 0)
+                    cluster.Distances[(size_t)i * count + j] = (uint16_t)distance;
+            }
+        }
+        cluster.Dirty = false;
+        rebuilt++;
+    }
+
+    // breadth first search from cell inside cluster c, stops early once it reaches target (if not -1)
+    void localSearch(const Maze& maze, int c, int cell, int target)
+    {
+        localX0 = (c % clustersX) * ClusterSize;
+        localY0 = (c / clustersX) * ClusterSize;
+        localWidth = std::min(ClusterSize, maze.Width - localX0);
+        localHeight = std::min(ClusterSize, maze.Height - localY0);
+        if (++localQuery == 0)
+        {
+            std::fill(localStamp.begin(), localStamp.end(), 0);
+            localQuery = 1;
+        }
+        int first = localIndex(cell % maze.Width, cell / maze.Width);
+        local[first] = 0;
+        localStamp[first] = localQuery;
+        size_t head = 0, tail = 0;
+        queue[tail++] = first;
+        while (head < tail)
+        {
+            int at = queue[head++];
+            int x = localX0 + at % ClusterSize, y = localY0 + at / ClusterSize;
+            if (maze.XYToIndex(x, y) == target)
+                return;
+            for (int dir = 0; dir < 4; ++dir)
+            {
+                int nx = x + MAZE_DX[dir], ny = y + MAZE_DY[dir];
+                if (nx < localX0 || ny < localY0 || nx >= localX0 + localWidth || ny >= localY0 + localHeight || maze.HasWall(x, y, dir))
+                    continue;
+                int next = localIndex(nx, ny);
+                if (localStamp[next] == localQuery)
+                    continue;
+                localStamp[next] = localQuery;
+                local[next] = local[at] + 1;
+                localDir[next] = (uint8_t)dir;
+                queue[tail++] = next;
+            }
+        }
+    }
+
+    int localIndex(int x, int y) const
+    {
+        return (y - localY0) * ClusterSize + (x - localX0);
+    }
+
+    // distance of cell from the last local search, -1 if it wasn't reached
+    int localDistance(int cell) const
+    {
+        int width = builtWidth;
+        int x = cell % width, y = cell / width;
+        if (x < localX0 || y < localY0 || x >= localX0 + localWidth || y >= localY0 + localHeight)
+            return -1;
+        int i = localIndex(x, y);
+        return localStamp[i] == localQuery ? local[i] : -1;
+    }
+
+    // appends the cells after from up to and including to, both inside cluster c
+    void appendLocalPath(const Maze& maze, int c, int from, int to, std::vector<int>& path)
+    {
+        if (from == to)
+            return;
+        localSearch(maze, c, from, to);
+        size_t end = path.size();
+        for (int cell = to; cell != from;)
+        {
+            path.push_back(cell);
+            int dir = localDir[localIndex(cell % maze.Width, cell / maze.Width)];
+            cell -= MAZE_DX[dir] + MAZE_DY[dir] * maze.Width;
+        }
+        std::reverse(path.begin() + end, path.end());
+    }
+};
+#endif
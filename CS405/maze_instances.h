@@ -0,0 +1,192 @@
+#ifndef MAZE_INSTANCES_H
+#define MAZE_INSTANCES_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "maze_mesh.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+// The maze drawn as instances of the one 1x1 plane: every quad is a model matrix in an
+// instance buffer, one buffer per material, and a material is one glDrawArraysInstanced() call.
+// The model matrices are worked out once when the quads are added, not every frame.
+// The vertex shader reads the instance's matrix from attributes INSTANCE_LOCATION to
+// INSTANCE_LOCATION + 3 (a mat4 takes four) instead of the model uniform.
+//
+// The quads of a material are a window that grows at the back with AddQuad() and shrinks at
+// the front with RemoveFront(), the way the endless maze builds rows ahead and drops them behind.
+// Upload() only copies the quads added since the last one and moves the attributes past the
+// removed ones. Once the back reaches the end of the buffer the window is moved to the front of
+// a buffer twice its size, so every quad is copied a constant number of times on average.
+class MazeInstances
+{
+public:
+    // first attribute location of the per-instance model matrix
+    enum { INSTANCE_LOCATION = 7 };
+
+    MazeInstances()
+    {
+        for (int i = 0; i < MazeMesh::MATERIAL_COUNT; i++)
+        {
+            VAO[i] = 0;
+            instanceVBO[i] = 0;
+            capacity[i] = 0;
+            uploadedCount[i] = 0;
+        }
+        Clear();
+    }
+
+    // drops the quads added so far, the buffers on the GPU stay until the next Upload()
+    void Clear()
+    {
+        for (int i = 0; i < MazeMesh::MATERIAL_COUNT; i++)
+        {
+            models[i].clear();
+            front[i] = 0;
+            bufferStart[i] = 0;
+            uploadedEnd[i] = 0;
+        }
+    }
+
+    // adds the unit plane translated to pos and rotated by rotation degrees around axis
+    void AddQuad(int material, glm::vec3 pos, float rotation, glm::vec3 axis)
+    {
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), pos);
+        if (rotation != 0.0f)
+            model = glm::rotate(model, glm::radians(rotation), axis);
+        models[material].push_back(model);
+    }
+
+    // drops the count oldest quads of a material, they stop being drawn after the next Upload()
+    void RemoveFront(int material, size_t count)
+    {
+        front[material] += std::min(count, QuadCount(material));
+    }
+
+    // copies the quads added since the last call to the GPU, creating the buffers the first time
+    void Upload()
+    {
+        if (quadVBO == 0)
+            createBuffers();
+        for (int i = 0; i < MazeMesh::MATERIAL_COUNT; i++)
+        {
+            std::vector<glm::mat4>& quads = models[i];
+            glBindBuffer(GL_ARRAY_BUFFER, instanceVBO[i]);
+            if (quads.size() - bufferStart[i] > capacity[i])
+            {
+                // the window no longer fits after the buffer's start, move it to the front of a
+                // new buffer, sized exactly the first time so a maze built once wastes nothing
+                quads.erase(quads.begin(), quads.begin() + front[i]);
+                front[i] = bufferStart[i] = 0;
+                capacity[i] = capacity[i] == 0 ? quads.size() : 2 * quads.size();
+                glBufferData(GL_ARRAY_BUFFER, capacity[i] * sizeof(glm::mat4), NULL, GL_DYNAMIC_DRAW);
+                uploadedEnd[i] = 0;
+            }
+            if (uploadedEnd[i] < quads.size())
+            {
+                glBufferSubData(GL_ARRAY_BUFFER, (uploadedEnd[i] - bufferStart[i]) * sizeof(glm::mat4),
+                    (quads.size() - uploadedEnd[i]) * sizeof(glm::mat4), quads.data() + uploadedEnd[i]);
+                uploadedEnd[i] = quads.size();
+            }
+            // the VAO reads the instances from the first quad that wasn't removed on
+            glBindVertexArray(VAO[i]);
+            for (int column = 0; column < 4; column++)
+            {
+                size_t offset = (front[i] - bufferStart[i]) * sizeof(glm::mat4) + column * sizeof(glm::vec4);
+                glVertexAttribPointer(INSTANCE_LOCATION + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)offset);
+            }
+            uploadedCount[i] = quads.size() - front[i];
+        }
+        glBindVertexArray(0);
+    }
+
+    // draws every quad of one material, the caller binds its textures first
+    void Draw(int material) const
+    {
+        if (uploadedCount[material] == 0)
+            return;
+        glBindVertexArray(VAO[material]);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 6, (GLsizei)uploadedCount[material]);
+    }
+
+    size_t QuadCount(int material) const { return models[material].size() - front[material]; }
+
+    // what Draw() binds and draws, for drawing through a RenderQueue
+    unsigned int VertexArray(int material) const { return VAO[material]; }
+    size_t InstanceCount(int material) const { return uploadedCount[material]; }
+
+    // deletes the GPU buffers, call while the GL context is still alive
+    void Release()
+    {
+        if (quadVBO == 0)
+            return;
+        glDeleteVertexArrays(MazeMesh::MATERIAL_COUNT, VAO);
+        glDeleteBuffers(1, &quadVBO);
+        glDeleteBuffers(MazeMesh::MATERIAL_COUNT, instanceVBO);
+        quadVBO = 0;
+        for (int i = 0; i < MazeMesh::MATERIAL_COUNT; i++)
+        {
+            VAO[i] = 0;
+            instanceVBO[i] = 0;
+            capacity[i] = 0;
+            uploadedCount[i] = 0;
+        }
+    }
+
+private:
+    std::vector<glm::mat4> models[MazeMesh::MATERIAL_COUNT];
+    // models[i] from front[i] on are the quads drawn. Element 0 of the instance buffer holds
+    // models[i][bufferStart[i]], which has room for capacity[i] quads, and the quads before
+    // uploadedEnd[i] are in it
+    size_t front[MazeMesh::MATERIAL_COUNT];
+    size_t bufferStart[MazeMesh::MATERIAL_COUNT];
+    size_t capacity[MazeMesh::MATERIAL_COUNT];
+    size_t uploadedEnd[MazeMesh::MATERIAL_COUNT];
+    unsigned int VAO[MazeMesh::MATERIAL_COUNT];
+    unsigned int quadVBO = 0;
+    unsigned int instanceVBO[MazeMesh::MATERIAL_COUNT];
+    size_t uploadedCount[MazeMesh::MATERIAL_COUNT];
+
+    void createBuffers()
+    {
+        // the plane every quad of the maze was drawn with, facing -z
+        static const float plane[] = {
+            -0.5f, -0.5f, -0.5f,  0.0f, 0.0f, -1.0f, 0.0f, 0.0f,
+             0.5f, -0.5f, -0.5f,  0.0f, 0.0f, -1.0f, 1.0f, 0.0f,
+             0.5f,  0.5f, -0.5f,  0.0f, 0.0f, -1.0f, 1.0f, 1.0f,
+             0.5f,  0.5f, -0.5f,  0.0f, 0.0f, -1.0f, 1.0f, 1.0f,
+            -0.5f,  0.5f, -0.5f,  0.0f, 0.0f, -1.0f, 0.0f, 1.0f,
+            -0.5f, -0.5f, -0.5f,  0.0f, 0.0f, -1.0f, 0.0f, 0.0f
+        };
+        glGenBuffers(1, &quadVBO);
+        glGenBuffers(MazeMesh::MATERIAL_COUNT, instanceVBO);
+        glGenVertexArrays(MazeMesh::MATERIAL_COUNT, VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(plane), plane, GL_STATIC_DRAW);
+        for (int i = 0; i < MazeMesh::MATERIAL_COUNT; i++)
+        {
+            glBindVertexArray(VAO[i]);
+            glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+            glEnableVertexAttribArray(2);
+            // the matrix columns advance once per instance, Upload() points them at the data
+            glBindBuffer(GL_ARRAY_BUFFER, instanceVBO[i]);
+            for (int column = 0; column < 4; column++)
+            {
+                glEnableVertexAttribArray(INSTANCE_LOCATION + column);
+                glVertexAttribDivisor(INSTANCE_LOCATION + column, 1);
+            }
+        }
+        glBindVertexArray(0);
+    }
+};
+#endif
@@ -0,0 +1,249 @@
+#ifndef MAZE_JPS_H
+#define MAZE_JPS_H
+
+#include "maze.h"
+#include "maze_path.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Jump Point Search for 4-connected mazes.
+// A corridor cell (open on exactly two sides) never offers a choice, so instead of stepping
+// through it one heap operation at a time the search jumps along the whole corridor, around
+// its bends, and only puts the cells where it branches (plus the goal) on the open list.
+// Corridors that end in a dead end that isn't the goal are dropped right away.
+//
+// The straight runs of a jump are bit scans: walking east along row y the run stops at the
+// first cell whose east wall is up or whose north or south side is open, which is the first
+// set bit of EastWalls(y) | ~SouthWalls(y - 1) | ~SouthWalls(y) after the start, 64 cells per
+// word. Vertical runs do the same on a transposed copy of the wall planes (one word holds 64
+// cells of a column) that is built on the first query and again whenever Maze::Revision()
+// changes.
+class JumpPointPathFinder : public PathFinder
+{
+public:
+    const char* Name() const override { return "jps"; }
+
+    bool FindPath(const Maze& maze, int startX, int startY, int goalX, int goalY, std::vector<int>& path) override
+    {
+        path.clear();
+        expanded = 0;
+        if (!maze.IsInBounds(startX, startY) || !maze.IsInBounds(goalX, goalY))
+            return false;
+        transpose(maze);
+        scratch.Begin((size_t)maze.Width * maze.Height);
+        entryDir.resize((size_t)maze.Width * maze.Height);
+        scratchBytes = scratch.Bytes() + entryDir.capacity() + (eastColumns.capacity() + southColumns.capacity()) * sizeof(uint64_t);
+        int width = maze.Width;
+        int start = maze.XYToIndex(startX, startY);
+        int goal = maze.XYToIndex(goalX, goalY);
+
+        scratch.Relax(start, 0, start);
+        scratch.Push(start, MazeManhattan(startX, startY, goalX, goalY));
+        while (!scratch.Empty())
+        {
+            int cell = scratch.Pop();
+            if (!scratch.Close(cell))
+                continue;
+            expanded++;
+            if (cell == goal)
+                break;
+
+            int x = cell % width;
+            int y = cell / width;
+            for (int dir = 0; dir < 4; ++dir)
+            {
+                // never jump back into the corridor the cell was reached through
+                if (maze.HasWall(x, y, dir) || (cell != start && dir == ((entryDir[cell] + 2) & 3)))
+                    continue;
+                int nx = x, ny = y, lastDir = dir;
+                int distance = jump(maze, nx, ny, lastDir, goalX, goalY);
+                if (distance == 0)
+                    continue;
+                int next = maze.XYToIndex(nx, ny);
+                uint32_t g = scratch.G(cell) + distance;
+                if (scratch.Relax(next, g, cell))
+                {
+                    entryDir[next] = (uint8_t)lastDir;
+                    scratch.Push(next, g + MazeManhattan(nx, ny, goalX, goalY));
+                }
+            }
+        }
+
+        bool found = scratch.IsClosed(goal);
+        if (found)
+        {
+            // walk every corridor back from the jump point to its parent, the corridor cells in
+            // between have only one other way out so the walk can't go wrong
+            for (int cell = goal; cell != start;)
+            {
+                int parent = scratch.Parent(cell);
+                int back = (entryDir[cell] + 2) & 3;
+                while (cell != parent)
+                {
+                    path.push_back(cell);
+                    cell += MAZE_DX[back] + MAZE_DY[back] * width;
+                    if (cell != parent)
+                        back = lowestBit(maze.OpenDirections(cell % width, cell / width) & ~(1 << ((back + 2) & 3)));
+                }
+            }
+            path.push_back(start);
+            std::reverse(path.begin(), path.end());
+        }
+        scratch.End();
+        return found;
+    }
+
+private:
+    PathScratch scratch;
+    // direction of the last step into each jump point, valid where the scratch has a parent
+    std::vector<uint8_t> entryDir;
+    // transposed wall planes, column x is wordsPerColumn words, bit y set if cell (x,y) has a
+    // wall on its east (south) side; padding bits past Height are set like the row planes
+    std::vector<uint64_t> eastColumns;
+    std::vector<uint64_t> southColumns;
+    int wordsPerColumn = 0;
+    uint64_t transposedRevision = 0;
+
+    // rebuilds the column planes if the maze isn't the revision they were built from
+    void transpose(const Maze& maze)
+    {
+        if (transposedRevision == maze.Revision())
+            return;
+        transposedRevision = maze.Revision();
+
+        wordsPerColumn = (maze.Height + 63) / 64;
+        eastColumns.assign((size_t)maze.Width * wordsPerColumn, ~0ull);
+        southColumns.assign((size_t)maze.Width * wordsPerColumn, ~0ull);
+        for (int y = 0; y < maze.Height; ++y)
+        {
+            const uint64_t* east = maze.EastWalls(y);
+            const uint64_t* south = maze.SouthWalls(y);
+            uint64_t bit = 1ull << (y & 63);
+            size_t word = y >> 6;
+            for (int x = 0; x < maze.Width; ++x)
+            {
+                if (!((east[x >> 6] >> (x & 63)) & 1))
+                    eastColumns[(size_t)x * wordsPerColumn + word] &= ~bit;
+                if (!((south[x >> 6] >> (x & 63)) & 1))
+                    southColumns[(size_t)x * wordsPerColumn + word] &= ~bit;
+            }
+        }
+    }
+
+    // index of the first set bit at or after from in the words returned by mask(i), or -1
+    template <typename Mask>
+    static int firstSet(Mask mask, int from, int words)
+    {
+        int i = from >> 6;
+        if (i >= words)
+            return -1;
+        uint64_t word = mask(i) & (~0ull << (from & 63));
+        while (true)
+        {
+            if (word)
+                return (i << 6) + lowestBit(word);
+            if (++i >= words)
+                return -1;
+            word = mask(i);
+        }
+    }
+
+    // index of the last set bit at or before from in the words returned by mask(i), or -1
+    template <typename Mask>
+    static int lastSet(Mask mask, int from)
+    {
+        if (from < 0)
+            return -1;
+        int i = from >> 6;
+        uint64_t word = mask(i) & (~0ull >> (63 - (from & 63)));
+        while (true)
+        {
+            if (word)
+                return (i << 6) + highestBit(word);
+            if (--i < 0)
+                return -1;
+            word = mask(i);
+        }
+    }
+
+    // follows the corridor from cell (x,y) through its open wall in direction dir until it gets
+    // to a cell with more than one way on or to the goal. x, y and dir are left at that cell and
+    // the direction of the last step, returns the number of steps or 0 if the corridor ends in a
+    // dead end (or comes back around to where it started)
+    int jump(const Maze& maze, int& x, int& y, int& dir, int goalX, int goalY) const
+    {
+        int startX = x, startY = y;
+        int distance = 0;
+        while (true)
+        {
+            int stop = run(maze, x, y, dir, goalX, goalY, startX, startY);
+            distance += std::abs(stop - (dir == EAST || dir == WEST ? x : y));
+            if (dir == EAST || dir == WEST)
+                x = stop;
+            else
+                y = stop;
+            if (x == goalX && y == goalY)
+                return distance;
+            int ways = maze.OpenDirections(x, y) & ~(1 << ((dir + 2) & 3));
+            if (ways == 0 || (x == startX && y == startY))
+                return 0;
+            if (ways & (ways - 1))
+                return distance;
+            // a bend, keep following the corridor
+            dir = lowestBit((uint64_t)ways);
+        }
+    }
+
+    // nearer of stop and target, a column (row) on the run from from in the direction forward
+    // or back, if target is on it
+    static int stopAt(int stop, int from, int target, bool forward)
+    {
+        if (forward ? (target > from && target < stop) : (target < from && target > stop))
+            return target;
+        return stop;
+    }
+
+    // one straight run of a jump, returns the column (row) of the first cell after (x,y) in
+    // direction dir that has a side open or a wall ahead, or of the goal or the cell the jump
+    // started from if that comes first. Stopping at the start ends a jump around a loop of
+    // corridor cells, which would otherwise run through its start for ever
+    int run(const Maze& maze, int x, int y, int dir, int goalX, int goalY, int originX, int originY) const
+    {
+        static const uint64_t allWalls = ~0ull;
+        int stop;
+        if (dir == EAST || dir == WEST)
+        {
+            const uint64_t* east = maze.EastWalls(y);
+            const uint64_t* north = y > 0 ? maze.SouthWalls(y - 1) : nullptr;
+            const uint64_t* south = maze.SouthWalls(y);
+            auto sides = [&](int i) { return ~(north ? north[i] : allWalls) | ~south[i]; };
+            // the west wall of cell c is the east wall of cell c - 1, the first column always has one
+            if (dir == EAST)
+                stop = firstSet([&](int i) { return east[i] | sides(i); }, x + 1, maze.WordsPerRow());
+            else
+                stop = lastSet([&](int i) { return (east[i] << 1) | (i > 0 ? east[i - 1] >> 63 : 1ull) | sides(i); }, x - 1);
+            if (goalY == y)
+                stop = stopAt(stop, x, goalX, dir == EAST);
+            if (originY == y)
+                stop = stopAt(stop, x, originX, dir == EAST);
+            return stop;
+        }
+
+        const uint64_t* south = &southColumns[(size_t)x * wordsPerColumn];
+        const uint64_t* east = &eastColumns[(size_t)x * wordsPerColumn];
+        const uint64_t* west = x > 0 ? &eastColumns[(size_t)(x - 1) * wordsPerColumn] : nullptr;
+        auto sides = [&](int i) { return ~east[i] | ~(west ? west[i] : allWalls); };
+        if (dir == SOUTH)
+            stop = firstSet([&](int i) { return south[i] | sides(i); }, y + 1, wordsPerColumn);
+        else
+            stop = lastSet([&](int i) { return (south[i] << 1) | (i > 0 ? south[i - 1] >> 63 : 1ull) | sides(i); }, y - 1);
+        if (goalX == x)
+            stop = stopAt(stop, y, goalY, dir == SOUTH);
+        if (originX == x)
+            stop = stopAt(stop, y, originY, dir == SOUTH);
+        return stop;
+    }
+};
+#endif
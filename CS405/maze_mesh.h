@@ -0,0 +1,339 @@
+#ifndef MAZE_MESH_H
+#define MAZE_MESH_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+struct MazeMeshVertex {
+    glm::vec3 Position;
+    glm::vec3 Normal;
+    glm::vec2 TexCoords;
+};
+
+// The floor and wall quads of the whole level baked into one vertex and index buffer per
+// material. Every quad is the 1x1 plane the level was drawn with before, moved and rotated
+// the way its model matrix did on the CPU, so the shader gets an identity model matrix and a
+// material is a single glDrawElements() instead of a draw call (and a setMat4) per quad.
+//
+// Before uploading, quads of the same material that lie in the same plane and face the same
+// way are merged greedily into rectangles: runs of neighbouring quads along a row first, then
+// runs that cover the same span in consecutive rows. Texture coordinates run from 0 to the
+// rectangle's size in quads, so with GL_REPEAT every unit of the rectangle shows the texture
+// exactly like the quad it replaced. The 3x2 quads of a wall side and the 3x3 quads of a floor
+// tile merge with their neighbours, so a straight corridor n cells long is one rectangle per
+// side and one for the floor instead of 12n quads. Quads that don't line up with the axes or
+// the half unit grid go in as they were added.
+class MazeMesh
+{
+public:
+    enum Material {
+        GROUND,
+        WALL,
+        MATERIAL_COUNT
+    };
+
+    // merge coplanar quads into rectangles, off uploads every quad as it was added
+    bool Greedy = true;
+
+    MazeMesh()
+    {
+        for (int i = 0; i < MATERIAL_COUNT; i++)
+        {
+            VAO[i] = VBO[i] = EBO[i] = 0;
+            uploadedIndices[i] = 0;
+        }
+    }
+
+    // drops the quads added so far, the buffers on the GPU stay until the next Upload()
+    void Clear()
+    {
+        cells.clear();
+        loose.clear();
+        addedQuads = 0;
+        for (int i = 0; i < MATERIAL_COUNT; i++)
+        {
+            vertices[i].clear();
+            indices[i].clear();
+        }
+    }
+
+    // adds the unit plane translated to pos and rotated by rotation degrees around axis
+    void AddQuad(int material, glm::vec3 pos, float rotation, glm::vec3 axis)
+    {
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), pos);
+        if (rotation != 0.0f)
+            model = glm::rotate(model, glm::radians(rotation), axis);
+        // the plane's corners, it faces -z like the planeVAO quad
+        glm::vec3 corner = glm::vec3(model * glm::vec4(-0.5f, -0.5f, -0.5f, 1.0f));
+        glm::vec3 uEdge = glm::vec3(model * glm::vec4(0.5f, -0.5f, -0.5f, 1.0f)) - corner;
+        glm::vec3 vEdge = glm::vec3(model * glm::vec4(-0.5f, 0.5f, -0.5f, 1.0f)) - corner;
+        glm::vec3 normal = glm::mat3(model) * glm::vec3(0.0f, 0.0f, -1.0f);
+        addedQuads++;
+
+        Cell cell;
+        cell.Material = material;
+        cell.U = axisOf(uEdge);
+        cell.V = axisOf(vEdge);
+        cell.N = axisOf(normal);
+        if (!Greedy || cell.U < 0 || cell.V < 0 || cell.N < 0 || !onGrid(corner))
+        {
+            // not lined up with the grid, goes in as it is
+            Loose quad = { material, corner, uEdge, vEdge, normal };
+            loose.push_back(quad);
+            return;
+        }
+        // corners lie on the half unit grid, twice their coordinates along each axis are integers
+        cell.UPos = half(corner, cell.U);
+        cell.VPos = half(corner, cell.V);
+        cell.NPos = half(corner, cell.N);
+        cells.push_back(cell);
+    }
+
+    // merges the quads and copies them to the GPU, creating the buffers the first time.
+    // The quads are kept, so more can be added and the mesh uploaded again
+    void Upload()
+    {
+        boundsMin = glm::vec3(FLT_MAX);
+        boundsMax = glm::vec3(-FLT_MAX);
+        for (int i = 0; i < MATERIAL_COUNT; i++)
+        {
+            vertices[i].clear();
+            indices[i].clear();
+        }
+        for (size_t i = 0; i < loose.size(); i++)
+            addRectangle(loose[i].Material, loose[i].Corner, loose[i].U, loose[i].V, loose[i].Normal, 1.0f, 1.0f);
+        merge();
+        for (int i = 0; i < MATERIAL_COUNT; i++)
+        {
+            if (VAO[i] == 0)
+            {
+                glGenVertexArrays(1, &VAO[i]);
+                glGenBuffers(1, &VBO[i]);
+                glGenBuffers(1, &EBO[i]);
+                glBindVertexArray(VAO[i]);
+                glBindBuffer(GL_ARRAY_BUFFER, VBO[i]);
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO[i]);
+                glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(MazeMeshVertex), (void*)0);
+                glEnableVertexAttribArray(0);
+                glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(MazeMeshVertex), (void*)offsetof(MazeMeshVertex, Normal));
+                glEnableVertexAttribArray(1);
+                glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(MazeMeshVertex), (void*)offsetof(MazeMeshVertex, TexCoords));
+                glEnableVertexAttribArray(2);
+            }
+            glBindVertexArray(VAO[i]);
+            glBindBuffer(GL_ARRAY_BUFFER, VBO[i]);
+            glBufferData(GL_ARRAY_BUFFER, vertices[i].size() * sizeof(MazeMeshVertex), vertices[i].data(), GL_STATIC_DRAW);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices[i].size() * sizeof(unsigned int), indices[i].data(), GL_STATIC_DRAW);
+            uploadedIndices[i] = indices[i].size();
+        }
+        glBindVertexArray(0);
+    }
+
+    // draws every quad of one material, the caller binds its textures first
+    void Draw(int material) const
+    {
+        if (uploadedIndices[material] == 0)
+            return;
+        glBindVertexArray(VAO[material]);
+        glDrawElements(GL_TRIANGLES, (GLsizei)uploadedIndices[material], GL_UNSIGNED_INT, 0);
+    }
+
+    // what Draw() binds and draws, for drawing through a RenderQueue
+    unsigned int VertexArray(int material) const { return VAO[material]; }
+    size_t IndexCount(int material) const { return uploadedIndices[material]; }
+
+    // quads added since Clear() and the rectangles they were merged into by the last Upload()
+    size_t AddedQuads() const { return addedQuads; }
+    size_t QuadCount(int material) const { return indices[material].size() / 6; }
+    bool Empty() const { return addedQuads == 0; }
+    size_t VertexCount() const
+    {
+        size_t count = 0;
+        for (int i = 0; i < MATERIAL_COUNT; i++)
+            count += vertices[i].size();
+        return count;
+    }
+
+    // box around the vertices of the last Upload(), min > max if there were none
+    glm::vec3 BoundsMin() const { return boundsMin; }
+    glm::vec3 BoundsMax() const { return boundsMax; }
+
+    // deletes the GPU buffers, call while the GL context is still alive
+    void Release()
+    {
+        for (int i = 0; i < MATERIAL_COUNT; i++)
+        {
+            if (VAO[i] == 0)
+                continue;
+            glDeleteVertexArrays(1, &VAO[i]);
+            glDeleteBuffers(1, &VBO[i]);
+            glDeleteBuffers(1, &EBO[i]);
+            VAO[i] = VBO[i] = EBO[i] = 0;
+            uploadedIndices[i] = 0;
+        }
+    }
+
+private:
+    // a unit quad waiting to be merged: its material, the axes (0..5 for +x, -x, +y, -y, +z, -z)
+    // its u and v texture directions and its normal point along, and twice the coordinate of
+    // its first corner along each of them
+    struct Cell {
+        int Material;
+        int U, V, N;
+        int UPos, VPos, NPos;
+    };
+
+    // a quad that doesn't line up with the grid, its first corner, edges and normal
+    struct Loose {
+        int Material;
+        glm::vec3 Corner, U, V, Normal;
+    };
+
+    std::vector<Cell> cells;
+    std::vector<Loose> loose;
+    size_t addedQuads = 0;
+    glm::vec3 boundsMin = glm::vec3(FLT_MAX), boundsMax = glm::vec3(-FLT_MAX);
+    std::vector<MazeMeshVertex> vertices[MATERIAL_COUNT];
+    std::vector<unsigned int> indices[MATERIAL_COUNT];
+    unsigned int VAO[MATERIAL_COUNT], VBO[MATERIAL_COUNT], EBO[MATERIAL_COUNT];
+    size_t uploadedIndices[MATERIAL_COUNT];
+
+    static glm::vec3 axisVector(int axis)
+    {
+        glm::vec3 v(0.0f);
+        v[axis / 2] = axis % 2 ? -1.0f : 1.0f;
+        return v;
+    }
+
+    // the axis a unit vector points along, -1 if it doesn't
+    static int axisOf(glm::vec3 v)
+    {
+        for (int axis = 0; axis < 6; axis++)
+        {
+            glm::vec3 d = v - axisVector(axis);
+            if (d.x * d.x + d.y * d.y + d.z * d.z < 1e-4f)
+                return axis;
+        }
+        return -1;
+    }
+
+    static bool onGrid(glm::vec3 p)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            if (std::fabs(p[i] * 2.0f - std::floor(p[i] * 2.0f + 0.5f)) > 1e-3f)
+                return false;
+        }
+        return true;
+    }
+
+    static int half(glm::vec3 p, int axis)
+    {
+        float along = p[axis / 2] * (axis % 2 ? -1.0f : 1.0f);
+        return (int)std::floor(along * 2.0f + 0.5f);
+    }
+
+    static bool samePlane(const Cell& a, const Cell& b)
+    {
+        return a.Material == b.Material && a.U == b.U && a.V == b.V && a.N == b.N && a.NPos == b.NPos;
+    }
+
+    void addRectangle(int material, glm::vec3 corner, glm::vec3 uEdge, glm::vec3 vEdge, glm::vec3 normal, float width, float height)
+    {
+        std::vector<MazeMeshVertex>& out = vertices[material];
+        unsigned int first = (unsigned int)out.size();
+        static const float uv[4][2] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f } };
+        for (int i = 0; i < 4; i++)
+        {
+            MazeMeshVertex vertex;
+            vertex.Position = corner + uEdge * (uv[i][0] * width) + vEdge * (uv[i][1] * height);
+            for (int k = 0; k < 3; k++)
+            {
+                boundsMin[k] = std::min(boundsMin[k], vertex.Position[k]);
+                boundsMax[k] = std::max(boundsMax[k], vertex.Position[k]);
+            }
+            vertex.Normal = normal;
+            vertex.TexCoords = glm::vec2(uv[i][0] * width, uv[i][1] * height);
+            out.push_back(vertex);
+        }
+        static const unsigned int quad[6] = { 0, 1, 2, 2, 3, 0 };
+        for (int i = 0; i < 6; i++)
+            indices[material].push_back(first + quad[i]);
+    }
+
+    // a rectangle of cells being grown row by row
+    struct Run {
+        int UFrom, UTo;
+        int VFrom, VTo;
+    };
+
+    void emit(const Cell& plane, const Run& run)
+    {
+        glm::vec3 u = axisVector(plane.U), v = axisVector(plane.V), n = axisVector(plane.N);
+        glm::vec3 corner = u * (run.UFrom * 0.5f) + v * (run.VFrom * 0.5f) + n * (plane.NPos * 0.5f);
+        addRectangle(plane.Material, corner, u, v, n, (run.UTo - run.UFrom) / 2 + 1.0f, (run.VTo - run.VFrom) / 2 + 1.0f);
+    }
+
+    // greedy merge of the cells of every plane: sorted by row, each row is cut into runs of
+    // neighbouring cells, and a run extends the rectangle above it if that covers the same span
+    void merge()
+    {
+        std::sort(cells.begin(), cells.end(), [](const Cell& a, const Cell& b) {
+            if (a.Material != b.Material) return a.Material < b.Material;
+            if (a.N != b.N) return a.N < b.N;
+            if (a.U != b.U) return a.U < b.U;
+            if (a.V != b.V) return a.V < b.V;
+            if (a.NPos != b.NPos) return a.NPos < b.NPos;
+            if (a.VPos != b.VPos) return a.VPos < b.VPos;
+            return a.UPos < b.UPos;
+        });
+        std::vector<Run> open, next;
+        size_t i = 0;
+        while (i < cells.size())
+        {
+            // one plane at a time
+            size_t end = i;
+            while (end < cells.size() && samePlane(cells[i], cells[end]))
+                end++;
+            open.clear();
+            while (i < end)
+            {
+                // the runs of one row, rectangles of the row before that end there are done
+                int row = cells[i].VPos;
+                next.clear();
+                size_t k = 0;
+                while (i < end && cells[i].VPos == row)
+                {
+                    Run run;
+                    run.UFrom = run.UTo = cells[i].UPos;
+                    run.VFrom = run.VTo = row;
+                    for (i++; i < end && cells[i].VPos == row && cells[i].UPos <= run.UTo + 2; i++)
+                        run.UTo = std::max(run.UTo, cells[i].UPos);
+                    // rectangles from the row above are sorted by span like the runs
+                    while (k < open.size() && open[k].UFrom < run.UFrom)
+                        emit(cells[end - 1], open[k++]);
+                    if (k < open.size() && open[k].UFrom == run.UFrom && open[k].UTo == run.UTo && open[k].VTo == row - 2)
+                    {
+                        run.VFrom = open[k].VFrom;
+                        k++;
+                    }
+                    next.push_back(run);
+                }
+                for (; k < open.size(); k++)
+                    emit(cells[end - 1], open[k]);
+                open.swap(next);
+            }
+            for (size_t k = 0; k < open.size(); k++)
+                emit(cells[end - 1], open[k]);
+        }
+    }
+};
+#endif
@@ -0,0 +1,125 @@
+#ifndef MAZE_PARALLEL_H
+#define MAZE_PARALLEL_H
+
+#include "maze.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Generates a perfect maze on several threads.
+// The maze is cut into tiles and every tile is carved on its own worker thread with the
+// same depth first search Maze::Generate() uses. Each tile is then a perfect maze on its
+// own, so the tiles are joined by opening exactly one wall on the seam between two tiles
+// for every edge of a random spanning tree over the tiles (Kruskal with a union-find),
+// which keeps the whole maze a perfect maze.
+class TiledMazeGenerator : public MazeGenerator
+{
+public:
+    // tile size in cells, TileWidth is kept a multiple of 64 so tiles never share a word of wall bits
+    int TileWidth;
+    int TileHeight;
+    // number of worker threads, 0 uses every hardware thread
+    int Threads;
+
+    TiledMazeGenerator(int tileWidth = 256, int tileHeight = 256, int threads = 0)
+        : TileWidth(std::max(64, tileWidth / 64 * 64)), TileHeight(std::max(1, tileHeight)), Threads(threads)
+    {
+    }
+
+    const char* Name() const override { return "tiled"; }
+
+    // carves the whole maze, walls are reset first. Every tile gets its own stream split from
+    // the seed, so the result only depends on the seed and the tile size, not on the thread count.
+    void Generate(Maze& maze, uint64_t seed) override
+    {
+        maze.Reset();
+        int tilesX = (maze.Width + TileWidth - 1) / TileWidth;
+        int tilesY = (maze.Height + TileHeight - 1) / TileHeight;
+        int tileCount = tilesX * tilesY;
+
+        // 1. carve every tile, workers pull the next tile index until none are left
+        std::atomic<int> nextTile(0);
+        std::atomic<size_t> tileScratch(0);
+        auto worker = [&]() {
+            for (int tile = nextTile++; tile < tileCount; tile = nextTile++)
+            {
+                int x0 = (tile % tilesX) * TileWidth;
+                int y0 = (tile / tilesX) * TileHeight;
+                int x1 = std::min(x0 + TileWidth, maze.Width);
+                int y1 = std::min(y0 + TileHeight, maze.Height);
+                Random random = Random(seed).Split(tile);
+                size_t bytes = maze.GenerateRegion(x0, y0, x1, y1, x0, y0, random);
+                size_t seen = tileScratch;
+                while (bytes > seen && !tileScratch.compare_exchange_weak(seen, bytes)) {}
+            }
+        };
+        int threads = Threads > 0 ? Threads : (int)std::thread::hardware_concurrency();
+        threads = std::max(1, std::min(threads, tileCount));
+        std::vector<std::thread> workers;
+        for (int i = 1; i < threads; ++i)
+            workers.push_back(std::thread(worker));
+        worker();
+        for (size_t i = 0; i < workers.size(); ++i)
+            workers[i].join();
+
+        // 2. stitch the tiles, one candidate wall picked at random on every seam
+        Random random = Random(seed).Split(tileCount);
+        std::vector<Seam> seams;
+        for (int ty = 0; ty < tilesY; ++ty)
+        {
+            for (int tx = 0; tx < tilesX; ++tx)
+            {
+                int x0 = tx * TileWidth;
+                int y0 = ty * TileHeight;
+                int x1 = std::min(x0 + TileWidth, maze.Width);
+                int y1 = std::min(y0 + TileHeight, maze.Height);
+                int tile = ty * tilesX + tx;
+                if (tx + 1 < tilesX)
+                    seams.push_back(Seam(tile, tile + 1, x1 - 1, y0 + (int)random.NextInt(y1 - y0), EAST));
+                if (ty + 1 < tilesY)
+                    seams.push_back(Seam(tile, tile + tilesX, x0 + (int)random.NextInt(x1 - x0), y1 - 1, SOUTH));
+            }
+        }
+        if (!seams.empty())
+            random.Shuffle(&seams[0], seams.size());
+
+        // 3. Kruskal over the tiles, only seams joining two different groups of tiles are opened
+        parent.resize(tileCount);
+        for (int i = 0; i < tileCount; ++i)
+            parent[i] = i;
+        for (size_t i = 0; i < seams.size(); ++i)
+        {
+            int a = find(seams[i].TileA);
+            int b = find(seams[i].TileB);
+            if (a == b)
+                continue;
+            parent[a] = b;
+            maze.Carve(seams[i].X, seams[i].Y, seams[i].Dir);
+        }
+        scratchBytes = tileScratch * threads + seams.capacity() * sizeof(Seam) + parent.capacity() * sizeof(int);
+    }
+
+private:
+    // a wall on the border between two neighbouring tiles
+    struct Seam {
+        int TileA, TileB;
+        int X, Y, Dir;
+        Seam(int a, int b, int x, int y, int dir) : TileA(a), TileB(b), X(x), Y(y), Dir(dir) {}
+    };
+
+    std::vector<int> parent;
+
+    // union-find root with path halving
+    int find(int i)
+    {
+        while (parent[i] != i)
+        {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    }
+};
+#endif
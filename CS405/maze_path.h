@@ -0,0 +1,242 @@
+#ifndef MAZE_PATH_H
+#define MAZE_PATH_H
+
+#include "maze.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+// Interface of the pathfinders that walk a Maze.
+// A path is the list of cell indices (Maze::XYToIndex()) from the start cell to the goal
+// cell, both included. Pathfinders keep their scratch buffers between queries, so one
+// instance per agent or per thread is cheap to query every frame.
+class PathFinder
+{
+public:
+    virtual ~PathFinder() {}
+
+    // name of the algorithm
+    virtual const char* Name() const = 0;
+
+    // finds a shortest path from cell (startX,startY) to cell (goalX,goalY), returns false if there is none
+    virtual bool FindPath(const Maze& maze, int startX, int startY, int goalX, int goalY, std::vector<int>& path) = 0;
+
+    // bytes of scratch memory held between queries
+    size_t ScratchBytes() const { return scratchBytes; }
+
+    // cells taken off the open list by the last query
+    size_t Expanded() const { return expanded; }
+
+protected:
+    size_t scratchBytes = 0;
+    size_t expanded = 0;
+};
+
+// Scratch memory of a best-first search over the cells of a maze, shared by the grid pathfinders.
+// Everything lives in flat arrays indexed by Maze::XYToIndex() that are allocated once for
+// the maze size: the g score, the parent cell and a closed set bitset, plus a binary heap of
+// (f, cell) keys. Instead of clearing the arrays before every query each cell carries the
+// number of the query that last wrote it, and only the closed set words that were touched are
+// cleared again, so a query costs what it expands, not the size of the maze.
+class PathScratch
+{
+public:
+    // sizes the arrays for a maze of cells cells (only reallocates when the size changes) and starts a new query
+    void Begin(size_t cells)
+    {
+        if (gScore.size() != cells)
+        {
+            gScore.assign(cells, 0);
+            stamp.assign(cells, 0);
+            parent.assign(cells, 0);
+            closed.assign((cells + 63) / 64, 0);
+            touched.reserve(closed.size());
+            heap.reserve(cells);
+            query = 0;
+        }
+        if (++query == 0)
+        {
+            std::fill(stamp.begin(), stamp.end(), 0);
+            query = 1;
+        }
+        heap.clear();
+    }
+
+    // clears the closed set words the query touched
+    void End()
+    {
+        for (size_t i = 0; i < touched.size(); ++i)
+            closed[touched[i]] = 0;
+        touched.clear();
+    }
+
+    size_t Bytes() const
+    {
+        return gScore.capacity() * sizeof(uint32_t) + stamp.capacity() * sizeof(uint32_t) + parent.capacity() * sizeof(int)
+            + closed.capacity() * sizeof(uint64_t) + touched.capacity() * sizeof(int) + heap.capacity() * sizeof(uint64_t);
+    }
+
+    // records g and the parent of cell if that is better than what the query knew, returns true if it was
+    bool Relax(int cell, uint32_t g, int from)
+    {
+        if (IsClosed(cell) || (stamp[cell] == query && gScore[cell] <= g))
+            return false;
+        stamp[cell] = query;
+        gScore[cell] = g;
+        parent[cell] = from;
+        return true;
+    }
+
+    uint32_t G(int cell) const { return gScore[cell]; }
+    int Parent(int cell) const { return parent[cell]; }
+
+    bool IsClosed(int cell) const
+    {
+        return (closed[cell >> 6] >> (cell & 63)) & 1;
+    }
+
+    // moves cell to the closed set, returns false if it already was there
+    bool Close(int cell)
+    {
+        uint64_t& word = closed[cell >> 6];
+        uint64_t bit = 1ull << (cell & 63);
+        if (word & bit)
+            return false;
+        if (word == 0)
+            touched.push_back(cell >> 6);
+        word |= bit;
+        return true;
+    }
+
+    bool Empty() const { return heap.empty(); }
+
+    void Push(int cell, uint32_t f)
+    {
+        uint64_t key = ((uint64_t)f << 32) | (uint32_t)cell;
+        size_t i = heap.size();
+        heap.push_back(key);
+        while (i > 0)
+        {
+            size_t up = (i - 1) / 2;
+            if (heap[up] <= key)
+                break;
+            heap[i] = heap[up];
+            i = up;
+        }
+        heap[i] = key;
+    }
+
+    // removes and returns the cell with the lowest f
+    int Pop()
+    {
+        int cell = (int)(uint32_t)heap[0];
+        uint64_t key = heap.back();
+        heap.pop_back();
+        size_t count = heap.size();
+        if (count > 0)
+        {
+            size_t i = 0;
+            while (true)
+            {
+                size_t child = 2 * i + 1;
+                if (child >= count)
+                    break;
+                if (child + 1 < count && heap[child + 1] < heap[child])
+                    child++;
+                if (key <= heap[child])
+                    break;
+                heap[i] = heap[child];
+                i = child;
+            }
+            heap[i] = key;
+        }
+        return cell;
+    }
+
+private:
+    // per cell scratch, only valid where stamp[cell] == query
+    std::vector<uint32_t> gScore;
+    std::vector<uint32_t> stamp;
+    std::vector<int> parent;
+    std::vector<uint64_t> closed;
+    std::vector<int> touched;
+    // min-heap of f << 32 | cell, a cell can be in it more than once, stale entries are skipped when closed
+    std::vector<uint64_t> heap;
+    uint32_t query = 0;
+};
+
+// Manhattan distance between two cells, the A* heuristic of the grid pathfinders
+inline uint32_t MazeManhattan(int x, int y, int goalX, int goalY)
+{
+    return (uint32_t)(std::abs(x - goalX) + std::abs(y - goalY));
+}
+
+// A* over the cells of the maze with Manhattan distance as heuristic, one cell per step.
+class AStarPathFinder : public PathFinder
+{
+public:
+    const char* Name() const override { return "astar"; }
+
+    bool FindPath(const Maze& maze, int startX, int startY, int goalX, int goalY, std::vector<int>& path) override
+    {
+        path.clear();
+        expanded = 0;
+        if (!maze.IsInBounds(startX, startY) || !maze.IsInBounds(goalX, goalY))
+            return false;
+        scratch.Begin((size_t)maze.Width * maze.Height);
+        scratchBytes = scratch.Bytes();
+        int width = maze.Width;
+        int start = maze.XYToIndex(startX, startY);
+        int goal = maze.XYToIndex(goalX, goalY);
+
+        scratch.Relax(start, 0, start);
+        scratch.Push(start, MazeManhattan(startX, startY, goalX, goalY));
+        while (!scratch.Empty())
+        {
+            int cell = scratch.Pop();
+            if (!scratch.Close(cell))
+                continue;
+            expanded++;
+            if (cell == goal)
+                break;
+
+            int x = cell % width;
+            int y = cell / width;
+            uint32_t g = scratch.G(cell) + 1;
+            // the walls of the cell straight from the packed planes
+            const uint64_t* east = maze.EastWalls(y);
+            const uint64_t* south = maze.SouthWalls(y);
+            bool walls[4] = {
+                y == 0 || ((maze.SouthWalls(y - 1)[x >> 6] >> (x & 63)) & 1),
+                ((east[x >> 6] >> (x & 63)) & 1) != 0,
+                ((south[x >> 6] >> (x & 63)) & 1) != 0,
+                x == 0 || ((east[(x - 1) >> 6] >> ((x - 1) & 63)) & 1)
+            };
+            for (int dir = 0; dir < 4; ++dir)
+            {
+                if (walls[dir])
+                    continue;
+                int next = cell + MAZE_DX[dir] + MAZE_DY[dir] * width;
+                if (scratch.Relax(next, g, cell))
+                    scratch.Push(next, g + MazeManhattan(x + MAZE_DX[dir], y + MAZE_DY[dir], goalX, goalY));
+            }
+        }
+
+        bool found = scratch.IsClosed(goal);
+        if (found)
+        {
+            for (int cell = goal; cell != start; cell = scratch.Parent(cell))
+                path.push_back(cell);
+            path.push_back(start);
+            std::reverse(path.begin(), path.end());
+        }
+        scratch.End();
+        return found;
+    }
+
+private:
+    PathScratch scratch;
+};
+#endif
@@ -0,0 +1,213 @@
+#ifndef MAZE_STREAM_H
+#define MAZE_STREAM_H
+
+#include "maze.h"
+#include "random.h"
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// Eller's algorithm: builds a perfect maze one row at a time, only remembering which set
+// every cell of the current row belongs to, so an endless maze needs O(width) memory.
+class EllerMaze
+{
+public:
+    // row width in cells
+    int Width;
+
+    EllerMaze(int width, uint64_t seed) : Width(width), random(seed), sets(width, -1), parent(2 * width), remaining(2 * width), hasDown(2 * width)
+    {
+    }
+
+    // generates the next row of the maze into packed wall rows of (Width + 63) / 64 words,
+    // bit x is set if cell x has a wall on its east (south) side, like Maze::EastWalls()
+    void NextRow(uint64_t* east, uint64_t* south)
+    {
+        int words = (Width + 63) / 64;
+        for (int i = 0; i < words; ++i)
+        {
+            east[i] = ~0ull;
+            south[i] = ~0ull;
+        }
+
+        // cells that weren't joined from the row above start a set of their own
+        int next = carried;
+        for (int x = 0; x < Width; ++x)
+        {
+            if (sets[x] < 0)
+                sets[x] = next++;
+        }
+        for (int i = 0; i < next; ++i)
+            parent[i] = i;
+
+        // randomly join neighbouring cells that belong to different sets
+        for (int x = 0; x + 1 < Width; ++x)
+        {
+            int a = find(sets[x]);
+            int b = find(sets[x + 1]);
+            if (a != b && (random.Next() & 1))
+            {
+                parent[a] = b;
+                east[x >> 6] &= ~(1ull << (x & 63));
+            }
+        }
+        for (int i = 0; i < next; ++i)
+        {
+            remaining[i] = 0;
+            hasDown[i] = 0;
+        }
+        for (int x = 0; x < Width; ++x)
+        {
+            sets[x] = find(sets[x]);
+            remaining[sets[x]]++;
+        }
+
+        // every set continues downwards at least once, at the last cell of the set if no earlier cell did
+        for (int x = 0; x < Width; ++x)
+        {
+            int set = sets[x];
+            remaining[set]--;
+            if ((random.Next() & 1) || (remaining[set] == 0 && !hasDown[set]))
+            {
+                hasDown[set] = 1;
+                south[x >> 6] &= ~(1ull << (x & 63));
+            }
+            else
+            {
+                sets[x] = -1;
+            }
+        }
+
+        // renumber the sets carried into the next row as 0..carried-1 so ids stay below 2 * Width
+        for (int i = 0; i < next; ++i)
+            remaining[i] = -1;
+        carried = 0;
+        for (int x = 0; x < Width; ++x)
+        {
+            if (sets[x] < 0)
+                continue;
+            if (remaining[sets[x]] < 0)
+                remaining[sets[x]] = carried++;
+            sets[x] = remaining[sets[x]];
+        }
+    }
+
+private:
+    Random random;
+    // set of every cell in the current row, -1 for cells that start a new set
+    std::vector<int> sets;
+    int carried = 0;
+    // union-find over the set ids of one row, plus per set scratch
+    std::vector<int> parent;
+    std::vector<int> remaining;
+    std::vector<char> hasDown;
+
+    int find(int i)
+    {
+        while (parent[i] != i)
+        {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    }
+};
+
+// A window of rows over an endless maze that grows in +y.
+// Rows are generated with Eller's algorithm when the window is advanced and dropped again
+// once they fall behind, so memory stays flat however far the maze goes. It answers the same
+// grid queries as Maze (IsOpen(), HasWall(), ...) for the rows currently held; rows that were
+// evicted or not generated yet read as solid wall.
+class MazeStream
+{
+public:
+    // width in cells
+    int Width;
+
+    MazeStream(int width, uint64_t seed) : Width(width), eller(width, seed)
+    {
+    }
+
+    // first cell row still held and one past the last generated row
+    long long FirstRow() const { return firstRow; }
+    long long EndRow() const { return firstRow + (long long)rows.size(); }
+
+    // generates the next row at the end of the window
+    void Advance()
+    {
+        int words = (Width + 63) / 64;
+        rows.push_back(Row());
+        rows.back().East.resize(words);
+        rows.back().South.resize(words);
+        eller.NextRow(&rows.back().East[0], &rows.back().South[0]);
+    }
+
+    // drops every row before row y
+    void EvictBefore(long long y)
+    {
+        while (firstRow < y && !rows.empty())
+        {
+            rows.pop_front();
+            firstRow++;
+        }
+    }
+
+    // size of the character grid, the height grows without end
+    int GridWidth() const { return 2 * Width + 1; }
+
+    // returns true if the grid position (x,y) is inside the endless character grid
+    bool IsInGrid(int x, long long y) const
+    {
+        return x >= 0 && x < GridWidth() && y >= 0;
+    }
+
+    // returns true if the cell (x,y) is held by the window
+    bool IsInBounds(int x, long long y) const
+    {
+        return x >= 0 && x < Width && y >= firstRow && y < EndRow();
+    }
+
+    // returns true if the grid position (x,y) is a passage, same layout as Maze::IsOpen()
+    bool IsOpen(int x, long long y) const
+    {
+        if (x < 0 || x >= GridWidth() || y < 0)
+            return false;
+        bool cellX = (x & 1) != 0;
+        bool cellY = (y & 1) != 0;
+        if (cellX && cellY)
+            return IsInBounds(x / 2, y / 2);
+        if (cellY)
+            return x > 0 && x < GridWidth() - 1 && IsInBounds(x / 2, y / 2) && !wall(row(y / 2).East, x / 2 - 1);
+        if (cellX)
+            return y > 0 && IsInBounds(x / 2, y / 2 - 1) && IsInBounds(x / 2, y / 2) && !wall(row(y / 2 - 1).South, x / 2);
+        return false;
+    }
+
+    // returns true if there is a wall between cell (x,y) and its neighbour in direction dir
+    bool HasWall(int x, long long y, int dir) const
+    {
+        return !IsOpen(2 * x + 1 + MAZE_DX[dir], 2 * y + 1 + MAZE_DY[dir]);
+    }
+
+private:
+    struct Row {
+        std::vector<uint64_t> East;
+        std::vector<uint64_t> South;
+    };
+
+    EllerMaze eller;
+    std::deque<Row> rows;
+    long long firstRow = 0;
+
+    const Row& row(long long y) const
+    {
+        return rows[(size_t)(y - firstRow)];
+    }
+
+    static bool wall(const std::vector<uint64_t>& bits, int x)
+    {
+        return (bits[x >> 6] >> (x & 63)) & 1;
+    }
+};
+#endif
@@ -0,0 +1,261 @@
+#ifndef MAZE_TREE_H
+#define MAZE_TREE_H
+
+#include "maze.h"
+#include "maze_path.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// A perfect maze seen as the spanning tree it is.
+// Build() roots the tree at cell (0,0) and numbers the cells in depth first order, so the
+// subtree of a cell is the range Enter(cell) .. Leave(cell) of that order. Then
+//   - the next step from a towards b is towards the parent of a, unless b is in the subtree of
+//     a, in which case it's towards the one child whose subtree holds b: O(1), no search;
+//   - the lowest common ancestor of a and b (Enter(a) < Enter(b)) is the parent of the
+//     shallowest cell numbered in (Enter(a), Enter(b)], a range minimum over the depths in
+//     depth first order, and the distance is depth(a) + depth(b) - 2 depth(lca).
+// The range minimum uses a sparse table over blocks of 16 depths plus a scan inside the two
+// end blocks, which keeps the memory near 20 bytes per cell instead of the
+// cells * log(cells) words of a full sparse table.
+class MazeTree
+{
+public:
+    // builds the tree, returns false (and answers nothing) if the maze isn't a perfect maze
+    bool Build(const Maze& maze)
+    {
+        width = maze.Width;
+        builtRevision = maze.Revision();
+        int cells = maze.Width * maze.Height;
+        parentDir.assign(cells, NONE);
+        enter.assign(cells, -1);
+        leave.assign(cells, -1);
+        order.resize(cells);
+        depths.resize(cells);
+        valid = false;
+        if (cells == 0)
+            return false;
+
+        // depth first numbering, the stack holds the cells on the path from the root
+        std::vector<int> stack;
+        stack.reserve(1024);
+        int counter = 0;
+        size_t openSides = 0;
+        stack.push_back(0);
+        enter[0] = counter;
+        order[counter] = 0;
+        depths[counter++] = 0;
+        while (!stack.empty())
+        {
+            int cell = stack.back();
+            int x = cell % width, y = cell / width;
+            bool descended = false;
+            for (int dir = 0; dir < 4 && !descended; ++dir)
+            {
+                if (maze.HasWall(x, y, dir))
+                    continue;
+                int next = cell + MAZE_DX[dir] + MAZE_DY[dir] * width;
+                if (enter[next] >= 0)
+                    continue;
+                parentDir[next] = (uint8_t)((dir + 2) & 3);
+                enter[next] = counter;
+                order[counter] = next;
+                depths[counter++] = depths[enter[cell]] + 1;
+                stack.push_back(next);
+                descended = true;
+            }
+            if (!descended)
+            {
+                openSides += countOpen(maze.OpenDirections(x, y));
+                leave[cell] = counter - 1;
+                stack.pop_back();
+            }
+        }
+        if (counter != cells || openSides / 2 != (size_t)cells - 1)
+            return false;
+
+        // minimum of every block of BLOCK depths, then minima over 2^k blocks
+        int blocks = (cells + BLOCK - 1) / BLOCK;
+        table.assign(1, std::vector<int>(blocks));
+        for (int b = 0; b < blocks; ++b)
+            table[0][b] = scan(b * BLOCK, std::min(cells, (b + 1) * BLOCK) - 1);
+        for (int k = 1; (1 << k) <= blocks; ++k)
+        {
+            table.push_back(std::vector<int>(blocks - (1 << k) + 1));
+            for (int b = 0; b + (1 << k) <= blocks; ++b)
+                table[k][b] = shallower(table[k - 1][b], table[k - 1][b + (1 << (k - 1))]);
+        }
+        valid = true;
+        return true;
+    }
+
+    // true if the tree was built from this revision of the maze and the maze is perfect
+    bool IsCurrent(const Maze& maze) const
+    {
+        return valid && builtRevision == maze.Revision();
+    }
+
+    // the maze revision the last Build() saw, 0 before the first, and whether it was perfect
+    uint64_t BuiltRevision() const { return builtRevision; }
+    bool IsValid() const { return valid; }
+
+    size_t MemoryBytes() const
+    {
+        size_t bytes = parentDir.capacity() + (enter.capacity() + leave.capacity() + order.capacity() + depths.capacity()) * sizeof(int);
+        for (size_t k = 0; k < table.size(); ++k)
+            bytes += table[k].capacity() * sizeof(int);
+        return bytes;
+    }
+
+    int Depth(int cell) const { return depths[enter[cell]]; }
+    int Enter(int cell) const { return enter[cell]; }
+    int Leave(int cell) const { return leave[cell]; }
+
+    // direction from cell to its parent, -1 for the root
+    int ParentDirection(int cell) const
+    {
+        return parentDir[cell] == NONE ? -1 : parentDir[cell];
+    }
+
+    // lowest common ancestor of two cells
+    int Ancestor(int a, int b) const
+    {
+        if (a == b)
+            return a;
+        int from = enter[a], to = enter[b];
+        if (from > to)
+            std::swap(from, to);
+        int cell = order[rangeMin(from + 1, to)];
+        return cell + MAZE_DX[parentDir[cell]] + MAZE_DY[parentDir[cell]] * width;
+    }
+
+    // number of steps between two cells, the ancestor is one shallower than the range minimum
+    int Distance(int a, int b) const
+    {
+        int from = enter[a], to = enter[b];
+        if (from == to)
+            return 0;
+        if (from > to)
+            std::swap(from, to);
+        return depths[from] + depths[to] - 2 * (depths[rangeMin(from + 1, to)] - 1);
+    }
+
+    // direction of the first step from cell a towards cell b, -1 if they are the same cell
+    int NextStep(int a, int b) const
+    {
+        if (a == b)
+            return -1;
+        if (enter[b] < enter[a] || enter[b] > leave[a])
+            return parentDir[a];
+        for (int dir = 0; dir < 4; ++dir)
+        {
+            if (dir == parentDir[a])
+                continue;
+            int x = a % width + MAZE_DX[dir], y = a / width + MAZE_DY[dir];
+            if (x < 0 || x >= width || y < 0)
+                continue;
+            int child = a + MAZE_DX[dir] + MAZE_DY[dir] * width;
+            if (child >= (int)enter.size() || parentDir[child] != ((dir + 2) & 3))
+                continue;
+            if (enter[b] >= enter[child] && enter[b] <= leave[child])
+                return dir;
+        }
+        return -1;
+    }
+
+private:
+    enum { NONE = 0xFF, BLOCK = 16 };
+
+    int width = 0;
+    uint64_t builtRevision = 0;
+    bool valid = false;
+    std::vector<uint8_t> parentDir;
+    std::vector<int> enter;
+    std::vector<int> leave;
+    // cell and depth of every position of the depth first order
+    std::vector<int> order;
+    std::vector<int> depths;
+    // table[k][b] is the position of the shallowest cell in blocks b .. b + 2^k - 1
+    std::vector<std::vector<int>> table;
+
+    static int countOpen(int ways)
+    {
+        return (ways & 1) + ((ways >> 1) & 1) + ((ways >> 2) & 1) + ((ways >> 3) & 1);
+    }
+
+    int shallower(int i, int j) const
+    {
+        return depths[j] < depths[i] ? j : i;
+    }
+
+    // position of the shallowest cell in from .. to by looking at each
+    int scan(int from, int to) const
+    {
+        int best = from;
+        for (int i = from + 1; i <= to; ++i)
+        {
+            if (depths[i] < depths[best])
+                best = i;
+        }
+        return best;
+    }
+
+    // position of the shallowest cell in from .. to
+    int rangeMin(int from, int to) const
+    {
+        int first = from / BLOCK, last = to / BLOCK;
+        if (first == last)
+            return scan(from, to);
+        int best = shallower(scan(from, (first + 1) * BLOCK - 1), scan(last * BLOCK, to));
+        if (first + 1 < last)
+        {
+            int count = last - first - 1;
+            int k = 0;
+            while ((2 << k) <= count)
+                k++;
+            best = shallower(best, shallower(table[k][first + 1], table[k][last - (1 << k)]));
+        }
+        return best;
+    }
+};
+
+// Paths in a perfect maze straight from the tree: every step is a MazeTree::NextStep(), so a
+// query costs the length of the path and nothing is searched. The tree is rebuilt when the
+// maze changes; mazes with loops get no path.
+class TreePathFinder : public PathFinder
+{
+public:
+    const char* Name() const override { return "tree"; }
+
+    const MazeTree& Tree() const { return tree; }
+
+    bool FindPath(const Maze& maze, int startX, int startY, int goalX, int goalY, std::vector<int>& path) override
+    {
+        path.clear();
+        expanded = 0;
+        if (!maze.IsInBounds(startX, startY) || !maze.IsInBounds(goalX, goalY))
+            return false;
+        // a maze that isn't perfect is remembered for its revision too, not rebuilt every query
+        if (tree.BuiltRevision() != maze.Revision())
+            tree.Build(maze);
+        if (!tree.IsValid())
+            return false;
+        scratchBytes = tree.MemoryBytes();
+        int cell = maze.XYToIndex(startX, startY);
+        int goal = maze.XYToIndex(goalX, goalY);
+        path.reserve(tree.Distance(cell, goal) + 1);
+        path.push_back(cell);
+        while (cell != goal)
+        {
+            int dir = tree.NextStep(cell, goal);
+            cell += MAZE_DX[dir] + MAZE_DY[dir] * maze.Width;
+            path.push_back(cell);
+        }
+        return true;
+    }
+
+private:
+    MazeTree tree;
+};
+#endif
@@ -0,0 +1,156 @@
+#ifndef MAZE_WAVEFRONT_H
+#define MAZE_WAVEFRONT_H
+
+#include "maze.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Breadth first search that moves a whole word of 64 cells per bit operation.
+// The frontier and the visited set are bit planes laid out like the maze's wall planes, so
+// one step of the wave out of a frontier word is four masked shifts: cells whose east wall is
+// open move one bit up, cells whose west wall (the east wall one bit down) is open move one
+// bit down, and the words of the same column in the rows above and below take the cells
+// whose north and south walls are open. Whatever isn't visited yet is the next frontier.
+//
+// A maze's wavefront is thin, a few cells wide even when it spans the whole maze, so only
+// the words that hold frontier cells are visited each step, kept in a list; a step costs the
+// words on the front, not the words of the maze.
+class MazeWavefront
+{
+public:
+    enum : uint32_t { UNREACHABLE = 0xFFFFFFFF };
+
+    // distance from cell (x,y) to every cell, UNREACHABLE where it can't be reached.
+    // Returns the number of cells reached
+    size_t Distances(const Maze& maze, int x, int y, std::vector<uint32_t>& distances)
+    {
+        distances.assign((size_t)maze.Width * maze.Height, UNREACHABLE);
+        int wordsPerRow = maze.WordsPerRow();
+        int width = maze.Width;
+        uint32_t* out = distances.data();
+        return flood(maze, x, y, [&](size_t word, uint64_t cells, uint32_t step) {
+            size_t first = (word / wordsPerRow) * (size_t)width + (word % wordsPerRow) * 64;
+            while (cells)
+            {
+                out[first + lowestBit(cells)] = step;
+                cells &= cells - 1;
+            }
+        });
+    }
+
+    // marks every cell that can be reached from cell (x,y), returns how many there are
+    size_t Reach(const Maze& maze, int x, int y)
+    {
+        return flood(maze, x, y, [](size_t, uint64_t, uint32_t) {});
+    }
+
+    // true if the last search reached cell (x,y)
+    bool Reached(int x, int y) const
+    {
+        return (state[2 * ((size_t)y * wordsPerRow + (x >> 6))] >> (x & 63)) & 1;
+    }
+
+    // distance to the farthest cell the last search reached
+    uint32_t Steps() const { return steps; }
+
+    size_t MemoryBytes() const
+    {
+        return (state.capacity() + frontierCells.capacity()) * sizeof(uint64_t)
+            + (frontier.capacity() + touched.capacity()) * sizeof(uint32_t);
+    }
+
+private:
+    int wordsPerRow = 0;
+    uint32_t steps = 0;
+    // the visited cells of every word followed by the cells the step being taken reached in it,
+    // side by side so both are one cache line. Only the words in touched have any of the latter
+    std::vector<uint64_t> state;
+    std::vector<uint32_t> touched;
+    // words of the frontier and the frontier cells in each
+    std::vector<uint32_t> frontier;
+    std::vector<uint64_t> frontierCells;
+
+    // adds the cells to word of the next frontier, less the ones already visited
+    void add(size_t word, uint64_t cells)
+    {
+        uint64_t* words = &state[2 * word];
+        cells &= ~words[0];
+        if (!cells)
+            return;
+        if (!words[1])
+            touched.push_back((uint32_t)word);
+        words[1] |= cells;
+    }
+
+    // the search itself, visit(word, cells, step) is called once for every word of every new frontier
+    template <typename Visit>
+    size_t flood(const Maze& maze, int x, int y, Visit visit)
+    {
+        wordsPerRow = maze.WordsPerRow();
+        size_t words = (size_t)wordsPerRow * maze.Height;
+        state.assign(2 * words, 0);
+        frontier.clear();
+        frontierCells.clear();
+        touched.clear();
+        steps = 0;
+        if (!maze.IsInBounds(x, y))
+            return 0;
+
+        const uint64_t* east = maze.EastWalls(0);
+        const uint64_t* south = maze.SouthWalls(0);
+        size_t start = (size_t)y * wordsPerRow + (x >> 6);
+        state[2 * start] = 1ull << (x & 63);
+        frontier.push_back((uint32_t)start);
+        frontierCells.push_back(state[2 * start]);
+        visit(start, state[2 * start], 0);
+        size_t reached = 1;
+        for (uint32_t step = 1; !frontier.empty(); ++step)
+        {
+            for (size_t f = 0; f < frontier.size(); ++f)
+            {
+                size_t word = frontier[f];
+                uint64_t cells = frontierCells[f];
+                size_t column = word % wordsPerRow;
+                // east: the last bit carries into the next word, an open east wall there means it exists
+                uint64_t moving = cells & ~east[word];
+                add(word, moving << 1);
+                if (moving >> 63)
+                    add(word + 1, 1);
+                // west: into bit b from bit b + 1 through the east wall of b
+                add(word, (cells >> 1) & ~east[word]);
+                if ((cells & 1) && column > 0 && !(east[word - 1] >> 63))
+                    add(word - 1, 1ull << 63);
+                // south and north, the last row has every south wall standing
+                moving = cells & ~south[word];
+                if (moving)
+                    add(word + wordsPerRow, moving);
+                if (word >= (size_t)wordsPerRow)
+                {
+                    moving = cells & ~south[word - wordsPerRow];
+                    if (moving)
+                        add(word - wordsPerRow, moving);
+                }
+            }
+
+            frontier.swap(touched);
+            touched.clear();
+            frontierCells.resize(frontier.size());
+            for (size_t f = 0; f < frontier.size(); ++f)
+            {
+                size_t word = frontier[f];
+                uint64_t cells = state[2 * word + 1];
+                state[2 * word + 1] = 0;
+                state[2 * word] |= cells;
+                frontierCells[f] = cells;
+                reached += popCount(cells);
+                visit(word, cells, step);
+            }
+            if (!frontier.empty())
+                steps = step;
+        }
+        return reached;
+    }
+};
+#endif
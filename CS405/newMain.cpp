@@ -8,44 +8,45 @@
 
 #include "camera.h"
 #include "entity.h"
-
+#include "maze.h"
+#include "maze_file.h"
+#include "maze_chunks.h"
+#include "maze_generators.h"
+#include "maze_instances.h"
+#include "maze_parallel.h"
+#include "maze_stream.h"
+#include "render_queue.h"
+#include "scene_uniforms.h"
+
+#include <array>
+#include <chrono>
+#include <deque>
 #include <iostream>
 
-struct gameObject {
-    glm::vec3 pos;
-    glm::vec3 size;
-    float rotation;
-    glm::vec3 rotAxis;
-    string texture;
-
-    gameObject() {
-        pos = glm::vec3(0.0f);
-        size = glm::vec3(1.0f);
-        rotation = 0.0f;
-        rotAxis = glm::vec3(0.0f);
-        texture = "ground";
-    }
-
-    gameObject(glm::vec3 p, float r = 0.0f, glm::vec3 ra = glm::vec3(0.0f, 0.0f, 0.0f), string t = "ground", glm::vec3 s = glm::vec3(1.0f, 1.0f, 1.0f)) {
-        pos = p;
-        size = s;
-        rotation = r;
-        rotAxis = ra;
-        texture = t;
-    }
-};
-
-std::vector <gameObject> objects;
+// the floor and wall quads of the maze, baked into chunks
+MazeChunks mazeChunks;
+// with --instanced the quads are drawn as instances of one quad instead
+bool instancedMaze = false;
+MazeInstances mazeInstances;
+// set when quads were added or removed since the last upload
+bool mazeDirty = false;
+// time compMap() took to add the quads, reported with the upload
+double mazeQuadSeconds = 0.0;
+// with --uniform-bench the time uploading the lights and setting the model matrix take is measured at startup
+bool uniformBenchmark = false;
+// with --render-stats the binds and uniform uploads the render queue issued in a frame are printed every second
+bool renderStats = false;
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow* window);
 unsigned int loadTexture(const char* path);
-void computeMap();
 void compMap();
+void updateMazeChunks();
+void updateMazeInstances();
+void updateEndlessMaze();
 void gravity();
-bool frustumCulling(glm::vec3 objPos, float size);
 
 // settings
 const unsigned int SCR_WIDTH = 800;
@@ -61,26 +62,60 @@ bool firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
-// Maze
-//----CONSTANTS-------------------------------------------------------
-#define GRID_WIDTH 30
-#define GRID_HEIGHT 15
-#define NORTH 0
-#define EAST 1
-#define SOUTH 2
-#define WEST 3
-//----GLOBAL VARIABLES------------------------------------------------
-char grid[GRID_WIDTH * GRID_HEIGHT];
-//----FUNCTION PROTOTYPES---------------------------------------------
-void ResetGrid();
-int XYToIndex(int x, int y);
-int IsInBounds(int x, int y);
-void Visit(int x, int y);
-void PrintGrid();
-/////////////////////////////////////////////////////////////////////
-
-int main()
+// maze, size in cells can be overridden from the command line
+int mazeWidth = 15;
+int mazeHeight = 7;
+// the same seed always builds the same maze, picked from the clock unless given with --seed
+uint64_t mazeSeed = 0;
+// generator picked with --algorithm, see MazeGeneratorNames()
+string mazeAlgorithm;
+// pre-generated maze file to map instead of generating (--load), and where to write the maze (--save)
+string mazeLoadPath;
+string mazeSavePath;
+Maze maze;
+
+// endless-runner mode, the maze keeps growing in +z while the player runs
+bool endlessMode = false;
+const long long ENDLESS_ROWS_AHEAD = 12;
+const long long ENDLESS_ROWS_BEHIND = 4;
+std::unique_ptr<MazeStream> mazeStream;
+// instances of each material each built grid row added, oldest row first
+std::deque<std::array<size_t, MazeMesh::MATERIAL_COUNT>> streamRowQuads;
+// first grid row that still has quads and the next grid row to build
+long long streamFirstGridRow = 0;
+long long streamNextGridRow = 0;
+
+int main(int argc, char** argv)
 {
+    // usage: [width height] [--endless] [--instanced] [--uniform-bench] [--seed n] [--algorithm name] [--load file] [--save file]
+    mazeSeed = (uint64_t)time(0);
+    int sizeArgs = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (string(argv[i]) == "--endless")
+            endlessMode = true;
+        else if (string(argv[i]) == "--instanced")
+            instancedMaze = true;
+        else if (string(argv[i]) == "--uniform-bench")
+            uniformBenchmark = true;
+        else if (string(argv[i]) == "--render-stats")
+            renderStats = true;
+        else if (string(argv[i]) == "--seed" && i + 1 < argc)
+            mazeSeed = strtoull(argv[++i], NULL, 10);
+        else if (string(argv[i]) == "--algorithm" && i + 1 < argc)
+            mazeAlgorithm = argv[++i];
+        else if (string(argv[i]) == "--load" && i + 1 < argc)
+            mazeLoadPath = argv[++i];
+        else if (string(argv[i]) == "--save" && i + 1 < argc)
+            mazeSavePath = argv[++i];
+        else if (sizeArgs == 0 && i + 1 < argc)
+        {
+            mazeWidth = atoi(argv[i]);
+            mazeHeight = atoi(argv[++i]);
+            sizeArgs++;
+        }
+    }
+
     // glfw: initialize and configure
     // ------------------------------
     glfwInit();
@@ -194,12 +229,68 @@ int main()
     };
 
     // Maze Generation
-    srand(time(0));
-    ResetGrid();
-    Visit(1, 1);
-    compMap();
-    PrintGrid();
-    //computeMap();
+    MazeFileHeader mazeHeader;
+    MazeFileMeta mazeMeta;
+    if (!endlessMode && !mazeLoadPath.empty())
+    {
+        // the file is mapped, not read, so even huge levels are ready right away
+        auto loadStart = std::chrono::high_resolution_clock::now();
+        if (LoadMazeFile(mazeLoadPath, maze, &mazeHeader, &mazeMeta))
+        {
+            double loadSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - loadStart).count();
+            mazeSeed = mazeHeader.Seed;
+            mazeWidth = maze.Width;
+            mazeHeight = maze.Height;
+            std::cout << "Maze " << maze.Width << "x" << maze.Height << " loaded from " << mazeLoadPath << " in " << loadSeconds * 1000.0 << " ms";
+            if (mazeMeta.Algorithm[0])
+                std::cout << " (" << mazeMeta.Algorithm << ", " << mazeMeta.DeadEnds << " dead ends)";
+            std::cout << std::endl;
+        }
+        else
+        {
+            mazeLoadPath.clear();
+        }
+    }
+    std::cout << "Maze seed " << mazeSeed << std::endl;
+    if (endlessMode)
+    {
+        // rows are generated (and dropped) while the player runs
+        mazeStream.reset(new MazeStream(mazeWidth, mazeSeed));
+        updateEndlessMaze();
+    }
+    else if (!mazeLoadPath.empty())
+    {
+        compMap();
+        if (maze.GridWidth() <= 200)
+            maze.Print(std::cout);
+    }
+    else
+    {
+        maze.Resize(mazeWidth, mazeHeight);
+        auto mazeStart = std::chrono::high_resolution_clock::now();
+        // big arenas are carved tile by tile on every core unless another algorithm was asked for
+        if (mazeAlgorithm.empty())
+            mazeAlgorithm = (double)mazeWidth * mazeHeight >= 1024.0 * 1024.0 ? "tiled" : "backtracker";
+        std::unique_ptr<MazeGenerator> generator = CreateMazeGenerator(mazeAlgorithm);
+        if (!generator)
+        {
+            std::cout << "Unknown maze algorithm " << mazeAlgorithm << ", using backtracker" << std::endl;
+            generator = CreateMazeGenerator("backtracker");
+        }
+        generator->Generate(maze, mazeSeed);
+        double mazeSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - mazeStart).count();
+        std::cout << "Maze " << maze.Width << "x" << maze.Height << " generated by " << generator->Name() << " in " << mazeSeconds * 1000.0 << " ms ("
+            << (double)maze.Width * maze.Height / mazeSeconds << " cells/sec)" << std::endl;
+        if (!mazeSavePath.empty())
+        {
+            MazeFileMeta meta = MakeMazeFileMeta(maze, generator->Name());
+            if (SaveMazeFile(mazeSavePath, maze, mazeSeed, &meta))
+                std::cout << "Maze saved to " << mazeSavePath << std::endl;
+        }
+        compMap();
+        if (maze.GridWidth() <= 200)
+            maze.Print(std::cout);
+    }
     /*****************/
 
     glm::vec3 pointLightPositions[] = {
@@ -264,6 +355,56 @@ int main()
     lightingShader.use();
     lightingShader.setInt("material.diffuse", 0);
     lightingShader.setInt("material.specular", 1);
+    lightingShader.setFloat("material.shininess", 32.0f);
+
+    // camera and lights go to every program through the uniform buffers of SceneUniforms
+    SceneUniforms::Bind(lightingShader);
+    SceneUniforms::Bind(lightCubeShader);
+    SceneUniforms::Bind(ourShader);
+    SceneUniforms sceneUniforms;
+    SceneLights lights = SceneLights();
+    lights.Dir.Direction = glm::vec3(-0.2f, -1.0f, -0.3f);
+    lights.Dir.Ambient = glm::vec3(0.05f);
+    lights.Dir.Diffuse = glm::vec3(0.4f);
+    lights.Dir.Specular = glm::vec3(0.5f);
+    for (int i = 0; i < SceneLights::POINT_LIGHTS; i++)
+    {
+        PointLight& light = lights.Points[i];
+        light.Position = pointLightPositions[i];
+        light.Ambient = glm::vec3(0.05f);
+        light.Diffuse = glm::vec3(0.8f);
+        light.Specular = glm::vec3(1.0f);
+        light.Constant = 1.0f;
+        light.Linear = 0.09f;
+        light.Quadratic = 0.032f;
+    }
+    lights.Spot.Ambient = glm::vec3(0.0f);
+    lights.Spot.Diffuse = glm::vec3(1.0f);
+    lights.Spot.Specular = glm::vec3(0.0f, 1.0f, 1.0f);
+    lights.Spot.Constant = 1.0f;
+    lights.Spot.Linear = 0.09f;
+    lights.Spot.Quadratic = 0.032f;
+    lights.Spot.CutOff = glm::cos(glm::radians(12.5f));
+    lights.Spot.OuterCutOff = glm::cos(glm::radians(15.0f));
+    if (uniformBenchmark)
+    {
+        BenchmarkSceneUniforms(sceneUniforms, lights);
+        BenchmarkUniformLocations(lightingShader);
+    }
+
+    // the uniforms that are still set per program every frame, looked up once here
+    UniformHandle<glm::mat4> modelUniform = lightingShader.getUniform<glm::mat4>("model");
+    UniformHandle<bool> instancedUniform = lightingShader.getUniform<bool>("instanced");
+    UniformHandle<glm::mat4> lightCubeModelUniform = lightCubeShader.getUniform<glm::mat4>("model");
+
+    // everything but the backpack model is drawn through the render queue, sorted so it binds as little as it can
+    RenderQueue renderQueue;
+    int lightingProgram = renderQueue.AddProgram(lightingShader.ID, modelUniform.Location, instancedUniform.Location);
+    int lightCubeProgram = renderQueue.AddProgram(lightCubeShader.ID, lightCubeModelUniform.Location);
+    int materials[MazeMesh::MATERIAL_COUNT];
+    materials[MazeMesh::GROUND] = renderQueue.AddMaterial(diffuseMapGround, specularMapGround);
+    materials[MazeMesh::WALL] = renderQueue.AddMaterial(diffuseMap, specularMap);
+    float lastStatsTime = 0.0f;
 
     // render loop
     // -----------
@@ -280,6 +421,8 @@ int main()
         // -----
         processInput(window);
         gravity();
+        if (endlessMode)
+            updateEndlessMaze();
 
         // render
         // ------
@@ -288,134 +431,80 @@ int main()
 
         // be sure to activate shader when setting uniforms/drawing objects
         lightingShader.use();
-        lightingShader.setVec3("viewPos", camera.Position);
-        lightingShader.setFloat("material.shininess", 32.0f);
-
-        // directional light
-        lightingShader.setVec3("dirLight.direction", -0.2f, -1.0f, -0.3f);
-        lightingShader.setVec3("dirLight.ambient", 0.05f, 0.05f, 0.05f);
-        lightingShader.setVec3("dirLight.diffuse", 0.4f, 0.4f, 0.4f);
-        lightingShader.setVec3("dirLight.specular", 0.5f, 0.5f, 0.5f);
-        // point light 1
-        lightingShader.setVec3("pointLights[0].position", pointLightPositions[0]);
-        lightingShader.setVec3("pointLights[0].ambient", 0.05f, 0.05f, 0.05f);
-        lightingShader.setVec3("pointLights[0].diffuse", 0.8f, 0.8f, 0.8f);
-        lightingShader.setVec3("pointLights[0].specular", 1.0f, 1.0f, 1.0f);
-        lightingShader.setFloat("pointLights[0].constant", 1.0f);
-        lightingShader.setFloat("pointLights[0].linear", 0.09);
-        lightingShader.setFloat("pointLights[0].quadratic", 0.032);
-        // point light 2
-        lightingShader.setVec3("pointLights[1].position", pointLightPositions[1]);
-        lightingShader.setVec3("pointLights[1].ambient", 0.05f, 0.05f, 0.05f);
-        lightingShader.setVec3("pointLights[1].diffuse", 0.8f, 0.8f, 0.8f);
-        lightingShader.setVec3("pointLights[1].specular", 1.0f, 1.0f, 1.0f);
-        lightingShader.setFloat("pointLights[1].constant", 1.0f);
-        lightingShader.setFloat("pointLights[1].linear", 0.09);
-        lightingShader.setFloat("pointLights[1].quadratic", 0.032);
-        // point light 3
-        lightingShader.setVec3("pointLights[2].position", pointLightPositions[2]);
-        lightingShader.setVec3("pointLights[2].ambient", 0.05f, 0.05f, 0.05f);
-        lightingShader.setVec3("pointLights[2].diffuse", 0.8f, 0.8f, 0.8f);
-        lightingShader.setVec3("pointLights[2].specular", 1.0f, 1.0f, 1.0f);
-        lightingShader.setFloat("pointLights[2].constant", 1.0f);
-        lightingShader.setFloat("pointLights[2].linear", 0.09);
-        lightingShader.setFloat("pointLights[2].quadratic", 0.032);
-        // point light 4
-        lightingShader.setVec3("pointLights[3].position", pointLightPositions[3]);
-        lightingShader.setVec3("pointLights[3].ambient", 0.05f, 0.05f, 0.05f);
-        lightingShader.setVec3("pointLights[3].diffuse", 0.8f, 0.8f, 0.8f);
-        lightingShader.setVec3("pointLights[3].specular", 1.0f, 1.0f, 1.0f);
-        lightingShader.setFloat("pointLights[3].constant", 1.0f);
-        lightingShader.setFloat("pointLights[3].linear", 0.09);
-        lightingShader.setFloat("pointLights[3].quadratic", 0.032);
-        // spotLight
-        lightingShader.setVec3("spotLight.position", camera.Position);
-        lightingShader.setVec3("spotLight.direction", camera.Front);
-        lightingShader.setVec3("spotLight.ambient", 0.0f, 0.0f, 0.0f);
-        lightingShader.setVec3("spotLight.diffuse", 1.0f, 1.0f, 1.0f);
-        lightingShader.setVec3("spotLight.specular", 0.0f, 1.0f, 1.0f);
-        lightingShader.setFloat("spotLight.constant", 1.0f);
-        lightingShader.setFloat("spotLight.linear", 0.09);
-        lightingShader.setFloat("spotLight.quadratic", 0.032);
-        lightingShader.setFloat("spotLight.cutOff", glm::cos(glm::radians(12.5f)));
-        lightingShader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(15.0f)));
 
         // view/projection transformations
         glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
         glm::mat4 view = camera.GetViewMatrix();
-        lightingShader.setMat4("projection", projection);
-        lightingShader.setMat4("view", view);
+        sceneUniforms.SetCamera(projection, view, camera.Position);
+
+        // directional, point and spot (flashlight) lights, only the flashlight moves so it is all that's uploaded
+        lights.Spot.Position = camera.Position;
+        lights.Spot.Direction = camera.Front;
+        sceneUniforms.SetLights(lights);
 
         // world transformation
         glm::mat4 model = glm::mat4(1.0f);
-        lightingShader.setMat4("model", model);
+        modelUniform.set(model);
 
         model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(0.0f, 10.0f, 0.0f)); // translate it down so it's at the center of the scene
         model = glm::scale(model, glm::vec3(0.1f, 0.1f, 0.1f));	// it's a bit too big for our scene, so scale it down
-        lightingShader.setMat4("model", model);
+        modelUniform.set(model);
         ourModel.Draw(lightingShader);
 
-        // bind diffuse map
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, diffuseMap);
-        // bind specular map
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, specularMap);
+        renderQueue.Clear();
 
         // render containers
-        glBindVertexArray(cubeVAO);
         for (unsigned int i = 0; i < 1; i++)
         {
-            // calculate the model matrix for each object and pass it to shader before drawing
+            // calculate the model matrix for each object and pass it to the queue
             glm::mat4 model = glm::mat4(1.0f);
             model = glm::translate(model, glm::vec3(0.0f, -10.0f, 0.0f));
-            lightingShader.setMat4("model", model);
-
-            glDrawArrays(GL_TRIANGLES, 0, 36);
+            renderQueue.AddArrays(lightingProgram, materials[MazeMesh::WALL], cubeVAO, 36, model, glm::length(glm::vec3(model[3]) - camera.Position));
         }
 
-
-        glBindVertexArray(planeVAO);
-        for (unsigned int i = 0; i < objects.size(); i++) {
-            if (objects[i].texture == "ground") {
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, diffuseMapGround);
-                // bind specular map
-                glActiveTexture(GL_TEXTURE1);
-                glBindTexture(GL_TEXTURE_2D, specularMapGround);
-            }
-            else if (objects[i].texture == "wall") {
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, diffuseMap);
-                // bind specular map
-                glActiveTexture(GL_TEXTURE1);
-                glBindTexture(GL_TEXTURE_2D, specularMap);
+        // the maze, one draw call per material for every chunk in view, the quads are already in world space.
+        // Instanced, it is one draw call per material for the whole maze
+        if (instancedMaze)
+        {
+            updateMazeInstances();
+            for (int m = 0; m < MazeMesh::MATERIAL_COUNT; m++)
+            {
+                if (mazeInstances.InstanceCount(m) > 0)
+                    renderQueue.AddArrays(lightingProgram, materials[m], mazeInstances.VertexArray(m), 6, glm::mat4(1.0f), 0.0f, (int)mazeInstances.InstanceCount(m));
             }
-
-            model = glm::mat4(1.0f);
-            model = glm::translate(model, objects[i].pos);
-            model = glm::rotate(model, glm::radians(objects[i].rotation), objects[i].rotAxis);
-            lightingShader.setMat4("model", model);
-            if (frustumCulling(objects[i].pos, objects[i].size.x)) {
-                glDrawArrays(GL_TRIANGLES, 0, 6);
+        }
+        else
+        {
+            updateMazeChunks();
+            mazeChunks.Cull(MazeFrustum(projection * view));
+            for (const MazeMesh* chunk : mazeChunks.Visible())
+            {
+                float depth = glm::length((chunk->BoundsMin() + chunk->BoundsMax()) * 0.5f - camera.Position);
+                for (int m = 0; m < MazeMesh::MATERIAL_COUNT; m++)
+                {
+                    if (chunk->IndexCount(m) > 0)
+                        renderQueue.AddElements(lightingProgram, materials[m], chunk->VertexArray(m), (int)chunk->IndexCount(m), glm::mat4(1.0f), depth);
+                }
             }
-            
         }
 
-        lightCubeShader.use();
-        lightCubeShader.setMat4("projection", projection);
-        lightCubeShader.setMat4("view", view);
-
-        // we now draw as many light bulbs as we have point lights.
-        glBindVertexArray(lightCubeVAO);
+        // we now draw as many light bulbs as we have point lights, they sample no textures.
         for (unsigned int i = 0; i < 4; i++)
         {
             model = glm::mat4(1.0f);
             model = glm::translate(model, pointLightPositions[i]);
             model = glm::scale(model, glm::vec3(0.2f)); // Make it a smaller cube
-            lightCubeShader.setMat4("model", model);
-            glDrawArrays(GL_TRIANGLES, 0, 36);
+            renderQueue.AddArrays(lightCubeProgram, RenderQueue::NO_MATERIAL, lightCubeVAO, 36, model, glm::length(pointLightPositions[i] - camera.Position));
+        }
+
+        const RenderStats& stats = renderQueue.Submit();
+        if (renderStats && currentFrame - lastStatsTime >= 1.0f)
+        {
+            lastStatsTime = currentFrame;
+            std::cout << "Render queue: " << stats.Draws << " draws, " << stats.StateChanges() << " state changes ("
+                << stats.ProgramBinds << " programs, " << stats.TextureBinds << " textures, " << stats.VertexArrayBinds << " vertex arrays, "
+                << stats.UniformUploads << " uniforms), " << stats.Skipped << " redundant skipped" << std::endl;
         }
 
         //erinc collision
@@ -438,6 +527,9 @@ int main()
     glDeleteVertexArrays(1, &planeVAO);
     glDeleteBuffers(1, &VBO);
     glDeleteBuffers(1, &VBO2);
+    mazeChunks.Release();
+    mazeInstances.Release();
+    sceneUniforms.Release();
 
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
@@ -445,122 +537,41 @@ int main()
     return 0;
 }
 
-// area calculation of a triangle
-float area(int x1, int y1, int x2, int y2, int x3, int y3)
-{
-    return abs((x1 * (y2 - y3) + x2 * (y3 - y1) + x3 * (y1 - y2)) / 2.0);
+// Collision detection by looking at the direction camera wants to move and check if it collides with the maze.
+// Every grid position of the maze covers a 3x3 area centered at (x * 3, z * 3): passages have a floor
+// below them (-1.5 < y < -0.5) and walls are solid between -0.5 < y < 1.5, which is exactly the space the
+// floor and wall quads built by compMap() occupy, so a lookup in the wall bits replaces the walk over every object.
+//---------------------------------------------------------------------------------------------------------------
+template <typename Grid>
+bool collidesWithGrid(const Grid& grid, glm::vec3 point) {
+    int x = (int)floor(point.x / 3.0f + 0.5f);
+    long long y = (long long)floor(point.z / 3.0f + 0.5f);
+    if (!grid.IsInGrid(x, y))
+        return false;
+    if (grid.IsOpen(x, y))
+        return point.y > -1.5f && point.y < -0.5f;
+    return point.y > -0.5f && point.y < 1.5f;
 }
 
-/* A function to check whether point P(x, y) lies inside the triangle formed
-   by A(x1, y1), B(x2, y2) and C(x3, y3) */
-bool isInside(int x1, int y1, int x2, int y2, int x3, int y3, int x, int y)
-{
-    /* Calculate area of triangle ABC */
-    float A = area(x1, y1, x2, y2, x3, y3);
-
-    /* Calculate area of triangle PBC */
-    float A1 = area(x, y, x2, y2, x3, y3);
-
-    /* Calculate area of triangle PAC */
-    float A2 = area(x1, y1, x, y, x3, y3);
-
-    /* Calculate area of triangle PAB */
-    float A3 = area(x1, y1, x2, y2, x, y);
-
-    /* Check if sum of A1, A2 and A3 is same as A */
-    return (A == A1 + A2 + A3);
+bool collidesWithMaze(glm::vec3 point) {
+    if (endlessMode)
+        return collidesWithGrid(*mazeStream, point);
+    return collidesWithGrid(maze, point);
 }
 
-// Frustum colling by looking forward the camera and checking the distances of objects to camera.
-//-----------------------------------------------------------------------------------------------
-
-bool frustumCulling(glm::vec3 objPos, float size) {
-    /*printf(std::to_string(camera.Front.x) + "y: " + std::to_string(camera.Front.y) + "z: " + std::to_string(camera.Front.z));*/
-
-    float left_right_distance = 40.0f;
-    float front_distance = 50.0f;
-
-    glm::vec3 frustumPlanePos = camera.Position + camera.Front * front_distance;
-
-    glm::vec3 point1Pos = frustumPlanePos - camera.Right * left_right_distance;
-    glm::vec3 point2Pos = frustumPlanePos + camera.Right * left_right_distance;
-
-    if (isInside(camera.Position.x, camera.Position.z, point1Pos.x, point1Pos.z, point2Pos.x, point2Pos.z, objPos.x, objPos.z) || 
-        isInside(camera.Position.x, camera.Position.z, point1Pos.x, point1Pos.z, point2Pos.x, point2Pos.z, objPos.x + size, objPos.z + size) || 
-        isInside(camera.Position.x, camera.Position.z, point1Pos.x, point1Pos.z, point2Pos.x, point2Pos.z, objPos.x - size, objPos.z - size) || 
-        isInside(camera.Position.x, camera.Position.z, point1Pos.x, point1Pos.z, point2Pos.x, point2Pos.z, objPos.x + size, objPos.z - size) || 
-        isInside(camera.Position.x, camera.Position.z, point1Pos.x, point1Pos.z, point2Pos.x, point2Pos.z, objPos.x - size, objPos.z + size)) {
-        return true;
-    }
-
-    return false;
-}
-
-// Collision detection by looking at the direction camera wants to move and check if it collides with any object.
-//---------------------------------------------------------------------------------------------------------------
-bool checkCollision(std::vector <gameObject> objects, string direction, float distance) {
-    for (int i = 0; i < objects.size(); i++) {
-        if (direction == "front") {
-            if ((camera.Position + camera.Front * distance).x > objects[i].pos.x - objects[i].size.x / 2 &&
-                (camera.Position + camera.Front * distance).x < objects[i].pos.x + objects[i].size.x / 2 &&
-                (camera.Position + camera.Front * distance).y > objects[i].pos.y - objects[i].size.y / 2 &&
-                (camera.Position + camera.Front * distance).y < objects[i].pos.y + objects[i].size.y / 2 &&
-                (camera.Position + camera.Front * distance).z > objects[i].pos.z - objects[i].size.z / 2 &&
-                (camera.Position + camera.Front * distance).z < objects[i].pos.z + objects[i].size.z / 2) {
-                return true;
-            }
-        }
-        else if (direction == "back") {
-            if ((camera.Position - camera.Front * distance).x > objects[i].pos.x - objects[i].size.x / 2 &&
-                (camera.Position - camera.Front * distance).x < objects[i].pos.x + objects[i].size.x / 2 &&
-                (camera.Position - camera.Front * distance).y > objects[i].pos.y - objects[i].size.y / 2 &&
-                (camera.Position - camera.Front * distance).y < objects[i].pos.y + objects[i].size.y / 2 &&
-                (camera.Position - camera.Front * distance).z > objects[i].pos.z - objects[i].size.z / 2 &&
-                (camera.Position - camera.Front * distance).z < objects[i].pos.z + objects[i].size.z / 2) {
-                return true;
-            }
-        }
-        else if (direction == "left") {
-            if ((camera.Position - camera.Right * distance).x > objects[i].pos.x - objects[i].size.x / 2 &&
-                (camera.Position - camera.Right * distance).x < objects[i].pos.x + objects[i].size.x / 2 &&
-                (camera.Position - camera.Right * distance).y > objects[i].pos.y - objects[i].size.y / 2 &&
-                (camera.Position - camera.Right * distance).y < objects[i].pos.y + objects[i].size.y / 2 &&
-                (camera.Position - camera.Right * distance).z > objects[i].pos.z - objects[i].size.z / 2 &&
-                (camera.Position - camera.Right * distance).z < objects[i].pos.z + objects[i].size.z / 2) {
-                return true;
-            }
-        }
-        else if (direction == "right") {
-            if ((camera.Position + camera.Right * distance).x > objects[i].pos.x - objects[i].size.x / 2 &&
-                (camera.Position + camera.Right * distance).x < objects[i].pos.x + objects[i].size.x / 2 &&
-                (camera.Position + camera.Right * distance).y > objects[i].pos.y - objects[i].size.y / 2 &&
-                (camera.Position + camera.Right * distance).y < objects[i].pos.y + objects[i].size.y / 2 &&
-                (camera.Position + camera.Right * distance).z > objects[i].pos.z - objects[i].size.z / 2 &&
-                (camera.Position + camera.Right * distance).z < objects[i].pos.z + objects[i].size.z / 2) {
-                return true;
-            }
-        }
-        else if (direction == "up") {
-            if ((camera.Position + camera.Up * distance).x > objects[i].pos.x - objects[i].size.x / 2 &&
-                (camera.Position + camera.Up * distance).x < objects[i].pos.x + objects[i].size.x / 2 &&
-                (camera.Position + camera.Up * distance).y > objects[i].pos.y - objects[i].size.y / 2 &&
-                (camera.Position + camera.Up * distance).y < objects[i].pos.y + objects[i].size.y / 2 &&
-                (camera.Position + camera.Up * distance).z > objects[i].pos.z - objects[i].size.z / 2 &&
-                (camera.Position + camera.Up * distance).z < objects[i].pos.z + objects[i].size.z / 2) {
-                return true;
-            }
-        }
-        else if (direction == "down") {
-            if ((camera.Position - camera.Up * distance).x > objects[i].pos.x - objects[i].size.x / 2 &&
-                (camera.Position - camera.Up * distance).x < objects[i].pos.x + objects[i].size.x / 2 &&
-                (camera.Position - camera.Up * distance).y > objects[i].pos.y - objects[i].size.y / 2 &&
-                (camera.Position - camera.Up * distance).y < objects[i].pos.y + objects[i].size.y / 2 &&
-                (camera.Position - camera.Up * distance).z > objects[i].pos.z - objects[i].size.z / 2 &&
-                (camera.Position - camera.Up * distance).z < objects[i].pos.z + objects[i].size.z / 2) {
-                return true;
-            }
-        }
-    }
+bool checkCollision(string direction, float distance) {
+    if (direction == "front")
+        return collidesWithMaze(camera.Position + camera.Front * distance);
+    else if (direction == "back")
+        return collidesWithMaze(camera.Position - camera.Front * distance);
+    else if (direction == "left")
+        return collidesWithMaze(camera.Position - camera.Right * distance);
+    else if (direction == "right")
+        return collidesWithMaze(camera.Position + camera.Right * distance);
+    else if (direction == "up")
+        return collidesWithMaze(camera.Position + camera.Up * distance);
+    else if (direction == "down")
+        return collidesWithMaze(camera.Position - camera.Up * distance);
     return false;
 }
 
@@ -571,316 +582,138 @@ void processInput(GLFWwindow* window)
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
 
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS && !checkCollision(objects, "front", 0.25))
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS && !checkCollision("front", 0.25))
         camera.ProcessKeyboard(FORWARD, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS && !checkCollision(objects, "back", 0.25))
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS && !checkCollision("back", 0.25))
         camera.ProcessKeyboard(BACKWARD, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS && !checkCollision(objects, "left", 0.25))
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS && !checkCollision("left", 0.25))
         camera.ProcessKeyboard(LEFT, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS && !checkCollision(objects, "right", 0.25))
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS && !checkCollision("right", 0.25))
         camera.ProcessKeyboard(RIGHT, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS && !checkCollision(objects, "up", 1))
+    if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS && !checkCollision("up", 1))
         camera.ProcessKeyboard(UP, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS && !checkCollision(objects, "down", 1))
+    if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS && !checkCollision("down", 1))
         camera.ProcessKeyboard(DOWN, deltaTime);
 }
 
-void compMap() {
-    for (int y = 0; y < GRID_HEIGHT; y++) {
-        for (int x = 0; x < GRID_WIDTH; x++) {
-            if (grid[XYToIndex(x, y)] == ' ') {
-                gameObject temp(glm::vec3(x * 3, -1, y * 3), 90.0f, glm::vec3(1.0f, 0.0f, 0.0f));
-                objects.push_back(temp);
-
-                temp = *new gameObject(glm::vec3(x * 3 - 1, -1, y * 3), 90.0f, glm::vec3(1.0f, 0.0f, 0.0f));
-                objects.push_back(temp);
-
-                temp = *new gameObject(glm::vec3(x * 3 + 1, -1, y * 3), 90.0f, glm::vec3(1.0f, 0.0f, 0.0f));
-                objects.push_back(temp);
-
-                temp = *new gameObject(glm::vec3(x * 3, -1, y * 3 - 1), 90.0f, glm::vec3(1.0f, 0.0f, 0.0f));
-                objects.push_back(temp);
-
-                temp = *new gameObject(glm::vec3(x * 3 - 1, -1, y * 3 - 1), 90.0f, glm::vec3(1.0f, 0.0f, 0.0f));
-                objects.push_back(temp);
-
-                temp = *new gameObject(glm::vec3(x * 3 + 1, -1, y * 3 - 1), 90.0f, glm::vec3(1.0f, 0.0f, 0.0f));
-                objects.push_back(temp);
-
-                temp = *new gameObject(glm::vec3(x * 3, -1, y * 3 + 1), 90.0f, glm::vec3(1.0f, 0.0f, 0.0f));
-                objects.push_back(temp);
-
-                temp = *new gameObject(glm::vec3(x * 3 - 1, -1, y * 3 + 1), 90.0f, glm::vec3(1.0f, 0.0f, 0.0f));
-                objects.push_back(temp);
-
-                temp = *new gameObject(glm::vec3(x * 3 + 1, -1, y * 3 + 1), 90.0f, glm::vec3(1.0f, 0.0f, 0.0f));
-                objects.push_back(temp);
-
-                // walls
-
-                if (grid[XYToIndex(x, y + 1)] != ' ') {
-                    gameObject temp(glm::vec3(x * 3, 0, y * 3 + 2), 0, glm::vec3(0.0f, 0.0f, 1.0f), "wall");
-                    objects.push_back(temp);
-
-                    temp = *new gameObject(glm::vec3(x * 3 + 1, 0, y * 3 + 2), 0, glm::vec3(0.0f, 0.0f, 1.0f), "wall");
-                    objects.push_back(temp);
-
-                    temp = *new gameObject(glm::vec3(x * 3 - 1, 0, y * 3 + 2), 0, glm::vec3(0.0f, 0.0f, 1.0f), "wall");
-                    objects.push_back(temp);
-
-                    temp = *new gameObject(glm::vec3(x * 3, 1, y * 3 + 2), 0, glm::vec3(0.0f, 0.0f, 1.0f), "wall");
-                    objects.push_back(temp);
-
-                    temp = *new gameObject(glm::vec3(x * 3 + 1, 1, y * 3 + 2), 0, glm::vec3(0.0f, 0.0f, 1.0f), "wall");
-                    objects.push_back(temp);
-
-                    temp = *new gameObject(glm::vec3(x * 3 - 1, 1, y * 3 + 2), 0, glm::vec3(0.0f, 0.0f, 1.0f), "wall");
-                    objects.push_back(temp);
-                }
-                if (grid[XYToIndex(x, y - 1)] != ' ') {
-                    gameObject temp(glm::vec3(x * 3, 0, y * 3 - 2), 180.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-                    objects.push_back(temp);
-
-                    temp = *new gameObject(glm::vec3(x * 3 + 1, 0, y * 3 - 2), 180.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-                    objects.push_back(temp);
-
-                    temp = *new gameObject(glm::vec3(x * 3 - 1, 0, y * 3 - 2), 180.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-                    objects.push_back(temp);
-
-                    temp = *new gameObject(glm::vec3(x * 3, 1, y * 3 - 2), 180.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-                    objects.push_back(temp);
-
-                    temp = *new gameObject(glm::vec3(x * 3 + 1, 1, y * 3 - 2), 180.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-                    objects.push_back(temp);
-
-                    temp = *new gameObject(glm::vec3(x * 3 - 1, 1, y * 3 - 2), 180.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-                    objects.push_back(temp);
-                }
-                if (grid[XYToIndex(x + 1, y)] != ' ') {
-                    gameObject temp(glm::vec3(x * 3 + 2, 0, y * 3), 90.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-                    objects.push_back(temp);
-
-                    temp = *new gameObject(glm::vec3(x * 3 + 2, 0, y * 3 + 1), 90.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-                    objects.push_back(temp);
-
-                    temp = *new gameObject(glm::vec3(x * 3 + 2, 0, y * 3 - 1), 90.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-                    objects.push_back(temp);
-
-                    temp = *new gameObject(glm::vec3(x * 3 + 2, 1, y * 3), 90.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-                    objects.push_back(temp);
-
-                    temp = *new gameObject(glm::vec3(x * 3 + 2, 1, y * 3 + 1), 90.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-                    objects.push_back(temp);
-
-                    temp = *new gameObject(glm::vec3(x * 3 + 2, 1, y * 3 - 1), 90.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-                    objects.push_back(temp);
-                }
-                if (grid[XYToIndex(x - 1, y)] != ' ') {
-                    gameObject temp(glm::vec3(x * 3 - 2, 0, y * 3), 270.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-                    objects.push_back(temp);
-
-                    temp = *new gameObject(glm::vec3(x * 3 - 2, 0, y * 3 + 1), 270.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-                    objects.push_back(temp);
-
-                    temp = *new gameObject(glm::vec3(x * 3 - 2, 0, y * 3 - 1), 270.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-                    objects.push_back(temp);
-
-                    temp = *new gameObject(glm::vec3(x * 3 - 2, 1, y * 3), 270.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-                    objects.push_back(temp);
-
-                    temp = *new gameObject(glm::vec3(x * 3 - 2, 1, y * 3 + 1), 270.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-                    objects.push_back(temp);
+// adds a quad of the maze to the instances with --instanced, to its chunk otherwise
+void addMazeQuad(int material, glm::vec3 pos, float rotation, glm::vec3 axis) {
+    if (instancedMaze)
+        mazeInstances.AddQuad(material, pos, rotation, axis);
+    else
+        mazeChunks.AddQuad(material, pos, rotation, axis);
+    mazeDirty = true;
+}
 
-                    temp = *new gameObject(glm::vec3(x * 3 - 2, 1, y * 3 - 1), 270.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-                    objects.push_back(temp);
+// builds the floor and wall quads of the grid rows y0 <= y < y1, works on anything with
+// the character grid queries of Maze (IsOpen(), GridWidth())
+template <typename Grid>
+void compMapRows(const Grid& grid, long long y0, long long y1) {
+    for (long long y = y0; y < y1; y++) {
+        for (int x = 0; x < grid.GridWidth(); x++) {
+            if (grid.IsOpen(x, y)) {
+                // a cell is 3x3 floor quads
+                for (int dz = -1; dz <= 1; dz++)
+                    for (int dx = -1; dx <= 1; dx++)
+                        addMazeQuad(MazeMesh::GROUND, glm::vec3(x * 3 + dx, -1, y * 3 + dz), 90.0f, glm::vec3(1.0f, 0.0f, 0.0f));
+
+                // walls, 3 quads wide and 2 high on every closed side
+                bool south = !grid.IsOpen(x, y + 1);
+                bool north = !grid.IsOpen(x, y - 1);
+                bool east = !grid.IsOpen(x + 1, y);
+                bool west = !grid.IsOpen(x - 1, y);
+                for (int h = 0; h <= 1; h++) {
+                    for (int d = -1; d <= 1; d++) {
+                        if (south)
+                            addMazeQuad(MazeMesh::WALL, glm::vec3(x * 3 + d, h, y * 3 + 2), 0.0f, glm::vec3(0.0f, 0.0f, 1.0f));
+                        if (north)
+                            addMazeQuad(MazeMesh::WALL, glm::vec3(x * 3 + d, h, y * 3 - 2), 180.0f, glm::vec3(0.0f, 1.0f, 0.0f));
+                        if (east)
+                            addMazeQuad(MazeMesh::WALL, glm::vec3(x * 3 + 2, h, y * 3 + d), 90.0f, glm::vec3(0.0f, 1.0f, 0.0f));
+                        if (west)
+                            addMazeQuad(MazeMesh::WALL, glm::vec3(x * 3 - 2, h, y * 3 + d), 270.0f, glm::vec3(0.0f, 1.0f, 0.0f));
+                    }
                 }
-                
             }
         }
     }
 }
 
-void computeMap() {
-    gameObject temp(glm::vec3(0.0f, 0.0f, -1.0f), 180.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-    objects.push_back(temp);
-    temp = *new gameObject(glm::vec3(1.0f, 0.0f, -1.0f), 180.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-    objects.push_back(temp);
-    temp = *new gameObject(glm::vec3(-1.0f, 0.0f, -1.0f), 180.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-    objects.push_back(temp);
-
-    temp = *new gameObject(glm::vec3(0.0f, 1.0f, -1.0f), 180.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-    objects.push_back(temp);
-    temp = *new gameObject(glm::vec3(1.0f, 1.0f, -1.0f), 180.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-    objects.push_back(temp);
-    temp = *new gameObject(glm::vec3(-1.0f, 1.0f, -1.0f), 180.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-    objects.push_back(temp);
-
-    int i;
-    for (i = 0; i < 20; i++) {
-        gameObject temp(glm::vec3(0.0f, -1.0f, 0.0f + i), 90.0f, glm::vec3(1.0f, 0.0f, 0.0f));
-        objects.push_back(temp);
-
-        temp = *new gameObject(glm::vec3(1.0f, -1.0f, 0.0f + i), 90.0f, glm::vec3(1.0f, 0.0f, 0.0f));
-        objects.push_back(temp);
-
-        temp = *new gameObject(glm::vec3(-1.0f, -1.0f, 0.0f + i), 90.0f, glm::vec3(1.0f, 0.0f, 0.0f));
-        objects.push_back(temp);
-
-        temp = *new gameObject(glm::vec3(2.0f, 0.0f, 0.0f + i), 90.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-        objects.push_back(temp);
-
-        temp = *new gameObject(glm::vec3(2.0f, 1.0f, 0.0f + i), 90.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-        objects.push_back(temp);
-
-        temp = *new gameObject(glm::vec3(-2.0f, 0.0f, 0.0f + i), 270.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-        objects.push_back(temp);
-
-        temp = *new gameObject(glm::vec3(-2.0f, 1.0f, 0.0f + i), 270.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-        objects.push_back(temp);
-    }
-    
-    // Left Turn
-    for (int j = 0; j < 3; j++) {
-
-        gameObject temp(glm::vec3(0.0f, -1.0f, 0.0f + i), 90.0f, glm::vec3(1.0f, 0.0f, 0.0f));
-        objects.push_back(temp);
-
-        temp = *new gameObject(glm::vec3(1.0f, -1.0f, 0.0f + i), 90.0f, glm::vec3(1.0f, 0.0f, 0.0f));
-        objects.push_back(temp);
-
-        temp = *new gameObject(glm::vec3(-1.0f, -1.0f, 0.0f + i), 90.0f, glm::vec3(1.0f, 0.0f, 0.0f));
-        objects.push_back(temp);
-
-        temp = *new gameObject(glm::vec3(-2.0f, 0.0f, 0.0f + i), 270.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-        objects.push_back(temp);
-
-        temp = *new gameObject(glm::vec3(-2.0f, 1.0f, 0.0f + i), 270.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-        objects.push_back(temp);
-
-        i++;
-    }
-
-    temp = *new gameObject(glm::vec3(0.0f, 0.0f, 0.0f + i), 0.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-    objects.push_back(temp);
-
-    temp = *new gameObject(glm::vec3(1.0f, 0.0f, 0.0f + i), 0.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-    objects.push_back(temp);
-
-    temp = *new gameObject(glm::vec3(-1.0f, 0.0f, 0.0f + i), 0.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-    objects.push_back(temp);
-
-    temp = *new gameObject(glm::vec3(0.0f, 1.0f, 0.0f + i), 0.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-    objects.push_back(temp);
-
-    temp = *new gameObject(glm::vec3(1.0f, 1.0f, 0.0f + i), 0.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-    objects.push_back(temp);
-
-    temp = *new gameObject(glm::vec3(-1.0f, 1.0f, 0.0f + i), 0.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-    objects.push_back(temp);
-
-    int x;
-    for (x = 0; x < 20; x++) {
-        gameObject temp(glm::vec3(2.0f + x, -1.0f, 0.0f + i - 2.0f), 90.0f, glm::vec3(1.0f, 0.0f, 0.0f));
-        objects.push_back(temp);
-
-        temp = *new gameObject(glm::vec3(2.0f + x, -1.0f, 1.0f + i - 2.0f), 90.0f, glm::vec3(1.0f, 0.0f, 0.0f));
-        objects.push_back(temp);
-
-        temp = *new gameObject(glm::vec3(2.0f + x, -1.0f, -1.0f + i - 2.0f), 90.0f, glm::vec3(1.0f, 0.0f, 0.0f));
-        objects.push_back(temp);
-
-        temp = *new gameObject(glm::vec3(2.0f + x, 0.0f, -2.0f + i - 2.0f), 180.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-        objects.push_back(temp);
-
-        temp = *new gameObject(glm::vec3(2.0f + x, 1.0f, -2.0f + i - 2.0f), 180.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-        objects.push_back(temp);
-
-        temp = *new gameObject(glm::vec3(2.0f + x, 0.0f, 2.0f + i - 2.0f), 0.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-        objects.push_back(temp);
+void compMap() {
+    auto start = std::chrono::high_resolution_clock::now();
+    compMapRows(maze, 0, maze.GridHeight());
+    mazeQuadSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
 
-        temp = *new gameObject(glm::vec3(2.0f + x, 1.0f, 2.0f + i - 2.0f), 0.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-        objects.push_back(temp);
+// uploads the chunks that quads were added to since the last call
+void updateMazeChunks() {
+    if (!mazeDirty)
+        return;
+    auto start = std::chrono::high_resolution_clock::now();
+    size_t uploaded = mazeChunks.Upload();
+    mazeDirty = false;
+    if (!endlessMode)
+    {
+        double seconds = mazeQuadSeconds + std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        std::cout << "Maze mesh " << mazeChunks.AddedQuads() << " quads merged into " << mazeChunks.QuadCount(MazeMesh::GROUND) << " floor and "
+            << mazeChunks.QuadCount(MazeMesh::WALL) << " wall rectangles in " << uploaded << " chunks, built in " << seconds * 1000.0 << " ms" << std::endl;
     }
+}
 
-    for (; x < 23; x++) {
-        gameObject temp(glm::vec3(2.0f + x, -1.0f, 0.0f + i - 2.0f), 90.0f, glm::vec3(1.0f, 0.0f, 0.0f));
-        objects.push_back(temp);
-
-        temp = *new gameObject(glm::vec3(2.0f + x, -1.0f, 1.0f + i - 2.0f), 90.0f, glm::vec3(1.0f, 0.0f, 0.0f));
-        objects.push_back(temp);
-
-        temp = *new gameObject(glm::vec3(2.0f + x, -1.0f, -1.0f + i - 2.0f), 90.0f, glm::vec3(1.0f, 0.0f, 0.0f));
-        objects.push_back(temp);
+// uploads the instances added since the last call, the instances of dropped rows were
+// removed by updateEndlessMaze() already
+void updateMazeInstances() {
+    if (!mazeDirty)
+        return;
+    auto start = std::chrono::high_resolution_clock::now();
+    mazeInstances.Upload();
+    mazeDirty = false;
+    if (!endlessMode)
+    {
+        double seconds = mazeQuadSeconds + std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        std::cout << "Maze instances " << mazeInstances.QuadCount(MazeMesh::GROUND) << " floor and " << mazeInstances.QuadCount(MazeMesh::WALL)
+            << " wall quads in 2 draw calls, built in " << seconds * 1000.0 << " ms" << std::endl;
     }
+}
 
-    temp = *new gameObject(glm::vec3(2.0f + x, 0.0f, i - 1.0f), 90.f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-    objects.push_back(temp);
-
-    temp = *new gameObject(glm::vec3(2.0f + x, 0.0f, i - 2.0f), 90.f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-    objects.push_back(temp);
-
-    temp = *new gameObject(glm::vec3(2.0f + x, 0.0f, i - 3.0f), 90.f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-    objects.push_back(temp);
-
-    temp = *new gameObject(glm::vec3(2.0f + x, 1.0f, i - 1.0f), 90.f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-    objects.push_back(temp);
-
-    temp = *new gameObject(glm::vec3(2.0f + x, 1.0f, i - 2.0f), 90.f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-    objects.push_back(temp);
-
-    temp = *new gameObject(glm::vec3(2.0f + x, 1.0f, i - 3.0f), 90.f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-    objects.push_back(temp);
-
-    for (; i < 40; i++) {
-        gameObject temp(glm::vec3(x + 1.0f, -1.0f, 0.0f + i), 90.0f, glm::vec3(1.0f, 0.0f, 0.0f));
-        objects.push_back(temp);
-
-        temp = *new gameObject(glm::vec3(x, -1.0f, 0.0f + i), 90.0f, glm::vec3(1.0f, 0.0f, 0.0f));
-        objects.push_back(temp);
-
-        temp = *new gameObject(glm::vec3(x - 1.0f, -1.0f, 0.0f + i), 90.0f, glm::vec3(1.0f, 0.0f, 0.0f));
-        objects.push_back(temp);
-
-        temp = *new gameObject(glm::vec3(x + 2.0f, 0.0f, 0.0f + i), 90.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-        objects.push_back(temp);
-
-        temp = *new gameObject(glm::vec3(x + 2.0f, 1.0f, 0.0f + i), 90.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-        objects.push_back(temp);
-
-        temp = *new gameObject(glm::vec3(x - 2.0f, 0.0f, 0.0f + i), 270.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-        objects.push_back(temp);
-
-        temp = *new gameObject(glm::vec3(x - 2.0f, 1.0f, 0.0f + i), 270.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-        objects.push_back(temp);
+// generates the endless maze up to ENDLESS_ROWS_AHEAD rows in front of the player and drops
+// the rows (and their quads) more than ENDLESS_ROWS_BEHIND rows behind, so the maze and
+// the quads only ever hold a fixed window of rows
+void updateEndlessMaze() {
+    long long playerRow = std::max(0LL, (long long)floor(camera.Position.z / 3.0f + 0.5f) / 2);
+    while (mazeStream->EndRow() < playerRow + ENDLESS_ROWS_AHEAD) {
+        mazeStream->Advance();
+        // a grid row can be built once the rows on both sides of it exist, which is every
+        // grid row up to the wall row above the row that was just generated
+        long long lastGridRow = 2 * (mazeStream->EndRow() - 1);
+        for (; streamNextGridRow <= lastGridRow; streamNextGridRow++) {
+            std::array<size_t, MazeMesh::MATERIAL_COUNT> added;
+            for (int m = 0; m < MazeMesh::MATERIAL_COUNT; m++)
+                added[m] = mazeInstances.QuadCount(m);
+            compMapRows(*mazeStream, streamNextGridRow, streamNextGridRow + 1);
+            for (int m = 0; m < MazeMesh::MATERIAL_COUNT; m++)
+                added[m] = mazeInstances.QuadCount(m) - added[m];
+            streamRowQuads.push_back(added);
+        }
     }
 
-    for (i = 0; i < 20; i++) {
-        gameObject temp(glm::vec3(x + 1.0f, -1.0f, 0.0f + i), 90.0f, glm::vec3(1.0f, 0.0f, 0.0f));
-        objects.push_back(temp);
-
-        temp = *new gameObject(glm::vec3(x, -1.0f, 0.0f + i), 90.0f, glm::vec3(1.0f, 0.0f, 0.0f));
-        objects.push_back(temp);
-
-        temp = *new gameObject(glm::vec3(x - 1.0f, -1.0f, 0.0f + i), 90.0f, glm::vec3(1.0f, 0.0f, 0.0f));
-        objects.push_back(temp);
-
-        temp = *new gameObject(glm::vec3(x + 2.0f, 0.0f, 0.0f + i), 90.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-        objects.push_back(temp);
-
-        temp = *new gameObject(glm::vec3(x + 2.0f, 1.0f, 0.0f + i), 90.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-        objects.push_back(temp);
-
-        temp = *new gameObject(glm::vec3(x - 2.0f, 0.0f, 0.0f + i), 270.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-        objects.push_back(temp);
-
-        temp = *new gameObject(glm::vec3(x - 2.0f, 1.0f, 0.0f + i), 270.0f, glm::vec3(0.0f, 1.0f, 0.0f), "wall");
-        objects.push_back(temp);
+    long long keepRow = playerRow - ENDLESS_ROWS_BEHIND;
+    if (keepRow > mazeStream->FirstRow()) {
+        mazeStream->EvictBefore(keepRow);
+        // a dropped row's instances are the oldest ones of their material
+        for (; streamFirstGridRow <= 2 * keepRow && !streamRowQuads.empty(); streamFirstGridRow++) {
+            for (int m = 0; m < MazeMesh::MATERIAL_COUNT; m++)
+                mazeInstances.RemoveFront(m, streamRowQuads.front()[m]);
+            streamRowQuads.pop_front();
+        }
+        // the walls of a grid row stand in the rows next to it, a chunk goes once the row after its last is gone too
+        mazeChunks.RemoveRowsBefore(streamFirstGridRow - 1);
+        mazeDirty = true;
     }
-    
 }
 
 void gravity() {
-    if(!checkCollision(objects, "front", 1) && !checkCollision(objects, "back", 1) && !checkCollision(objects, "down", 1))
+    if(!checkCollision("front", 1) && !checkCollision("back", 1) && !checkCollision("down", 1))
         camera.Position -= glm::vec3(0.0f, 1.0f, 0.0f) * deltaTime;
 }
 
@@ -959,87 +792,3 @@ unsigned int loadTexture(char const* path)
 
     return textureID;
 }
-
-void ResetGrid()
-{
-    // Fills the grid with walls ('#' characters).
-    for (int i = 0; i < GRID_WIDTH * GRID_HEIGHT; ++i)
-    {
-        grid[i] = '#';
-    }
-}
-int XYToIndex(int x, int y)
-{
-    // Converts the two-dimensional index pair (x,y) into a
-    // single-dimensional index. The result is y * ROW_WIDTH + x.
-    return y * GRID_WIDTH + x;
-}
-int IsInBounds(int x, int y)
-{
-    // Returns "true" if x and y are both in-bounds.
-    if (x < 0 || x >= GRID_WIDTH) return false;
-    if (y < 0 || y >= GRID_HEIGHT) return false;
-    return true;
-}
-// This is the recursive function we will code in the next project
-void Visit(int x, int y)
-{
-    // Starting at the given index, recursively visits every direction in a
-    // randomized order.
-    // Set my current location to be an empty passage.
-    grid[XYToIndex(x, y)] = ' ';
-    // Create an local array containing the 4 directions and shuffle their order.
-    int dirs[4];
-    dirs[0] = NORTH;
-    dirs[1] = EAST;
-    dirs[2] = SOUTH;
-    dirs[3] = WEST;
-    for (int i = 0; i < 4; ++i)
-    {
-        int r = rand() & 3;
-        int temp = dirs[r];
-        dirs[r] = dirs[i];
-        dirs[i] = temp;
-    }
-    // Loop through every direction and attempt to Visit that direction.
-    for (int i = 0; i < 4; ++i)
-    {
-        // dx,dy are offsets from current location. Set them based
-        // on the next direction I wish to try.
-        int dx = 0, dy = 0;
-        switch (dirs[i])
-        {
-        case NORTH: dy = -1; break;
-        case SOUTH: dy = 1; break;
-        case EAST: dx = 1; break;
-        case WEST: dx = -1; break;
-        }
-        // Find the (x,y) coordinates of the grid cell 2 spots
-        // away in the given direction.
-        int x2 = x + (dx << 1);
-        int y2 = y + (dy << 1);
-        if (IsInBounds(x2, y2))
-        {
-            if (grid[XYToIndex(x2, y2)] == '#')
-            {
-                // (x2,y2) has not been visited yet... knock down the
-                // wall between my current position and that position
-                grid[XYToIndex(x2 - dx, y2 - dy)] = ' ';
-                // Recursively Visit (x2,y2)
-                Visit(x2, y2);
-            }
-        }
-    }
-}
-void PrintGrid()
-{
-    // Displays the finished maze to the screen.
-    for (int y = 0; y < GRID_HEIGHT; ++y)
-    {
-        for (int x = 0; x < GRID_WIDTH; ++x)
-        {
-            cout << grid[XYToIndex(x, y)];
-        }
-        cout << endl;
-    }
-}
\ No newline at end of file
@@ -0,0 +1,78 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Seedable counter based random number generator.
+// The n-th number of a stream is a pure function of (seed, stream, n): the SplitMix64
+// finalizer applied to a key mixed from the seed and stream id plus the counter. Nothing is
+// shared between instances, so every thread or tile can own its own stream without locks,
+// and the same seed always gives the same numbers on every machine.
+class Random
+{
+public:
+    uint64_t Seed;
+    uint64_t Stream;
+
+    Random(uint64_t seed = 0, uint64_t stream = 0) : Seed(seed), Stream(stream), counter(0)
+    {
+        key = mix(seed ^ mix(stream + 0x9E3779B97F4A7C15ull));
+    }
+
+    // returns an independent generator for sub stream id, e.g. one per tile or per thread
+    Random Split(uint64_t id) const
+    {
+        return Random(Seed, mix(Stream * 0xD1342543DE82EF95ull + id + 1));
+    }
+
+    // returns the next 64 random bits
+    uint64_t Next()
+    {
+        return mix(key + 0x9E3779B97F4A7C15ull * ++counter);
+    }
+
+    // returns a random integer in [0, n)
+    uint32_t NextInt(uint32_t n)
+    {
+        // multiply-shift instead of modulo, no division and no bias worth mentioning for small n
+        return (uint32_t)(((Next() >> 32) * n) >> 32);
+    }
+
+    // returns a random float in [0, 1)
+    float NextFloat()
+    {
+        return (Next() >> 40) * (1.0f / 16777216.0f);
+    }
+
+    // shuffles count items in place (Fisher-Yates), the same on every standard library unlike std::shuffle
+    template <typename T>
+    void Shuffle(T* items, size_t count)
+    {
+        for (size_t i = count; i > 1; --i)
+        {
+            size_t j = i <= 0xFFFFFFFFull ? NextInt((uint32_t)i) : (size_t)(Next() % i);
+            T temp = items[i - 1];
+            items[i - 1] = items[j];
+            items[j] = temp;
+        }
+    }
+
+    // jumps to the n-th number of the stream
+    void Seek(uint64_t n)
+    {
+        counter = n;
+    }
+
+private:
+    uint64_t key;
+    uint64_t counter;
+
+    static uint64_t mix(uint64_t z)
+    {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+};
+#endif
@@ -5,6 +5,7 @@
 #include <vector>
 #include "ray.hpp"
 #include <limits>
+#include "../random.h"
 
 using namespace std;
 
@@ -17,8 +18,11 @@ void writeImage(glm::vec3 color, std::ofstream& output)
     output << r << " " << g << " " << b << endl;
 }
 
+// a render thread should own its own Random (split from this one) instead of sharing it
+Random rayRandom(1);
+
 float randFloat() {
-    return 2.0 * (static_cast <float> (rand()) / static_cast <float> (RAND_MAX)) - 1;
+    return 2.0f * rayRandom.NextFloat() - 1.0f;
 }
 
 #endif
\ No newline at end of file
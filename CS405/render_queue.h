@@ -0,0 +1,285 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+// what Submit() did in a frame, every bind and uniform upload it issued is a state change
+struct RenderStats {
+    size_t Draws = 0;
+    size_t ProgramBinds = 0;
+    size_t TextureBinds = 0;
+    size_t VertexArrayBinds = 0;
+    size_t UniformUploads = 0;
+    // binds and uploads left out because the state was already set
+    size_t Skipped = 0;
+
+    size_t StateChanges() const { return ProgramBinds + TextureBinds + VertexArrayBinds + UniformUploads; }
+};
+
+// Collects a frame's draw calls and submits them sorted so that draws sharing a program,
+// a material and a vertex array follow each other, and only binds what changed between two
+// draws. Every item gets a 64 bit key, most significant first:
+//   program (8 bits) | material (12 bits) | vertex array (12 bits) | depth (32 bits)
+// The depth is the float distance to the camera, whose bits sort like the number for
+// positive floats, so within a batch opaque draws go front to back. The keys are sorted with
+// an LSD radix sort, 8 bits a pass, and passes in which every key has the same byte are skipped.
+//
+// Programs and materials are registered once and referred to by index. Vertex array names grow
+// with every buffer the maze creates, so the key holds the order in which each was first added
+// this frame instead, which stays small however many were made. A program's model and
+// instanced uniforms are set per item: the model matrix for plain draws, instanced for
+// instanced ones (see colors.vert).
+class RenderQueue
+{
+public:
+    // material of items that sample no textures, the textures bound stay as they are
+    enum { NO_MATERIAL = -1 };
+
+    // registers a program, its model and instanced uniform locations (-1 if it has none)
+    int AddProgram(unsigned int program, int modelLocation, int instancedLocation = -1)
+    {
+        Program entry = { program, modelLocation, instancedLocation };
+        programs.push_back(entry);
+        return (int)programs.size() - 1;
+    }
+
+    // registers the diffuse and specular textures drawn with, bound to texture units 0 and 1
+    int AddMaterial(unsigned int diffuse, unsigned int specular)
+    {
+        Material entry = { { diffuse, specular } };
+        materials.push_back(entry);
+        return (int)materials.size() - 1;
+    }
+
+    void Clear()
+    {
+        items.clear();
+        order.clear();
+        vertexArrays.clear();
+    }
+
+    // glDrawArrays(GL_TRIANGLES, 0, count) with the model matrix model, or instanced
+    // glDrawArraysInstanced() when instances > 0
+    void AddArrays(int program, int material, unsigned int vertexArray, int count, const glm::mat4& model, float depth, int instances = 0)
+    {
+        Item& item = add(program, material, vertexArray, depth);
+        item.Count = count;
+        item.Indexed = false;
+        item.Instances = instances;
+        item.Model = model;
+    }
+
+    // glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, 0) with the model matrix model
+    void AddElements(int program, int material, unsigned int vertexArray, int count, const glm::mat4& model, float depth)
+    {
+        Item& item = add(program, material, vertexArray, depth);
+        item.Count = count;
+        item.Indexed = true;
+        item.Instances = 0;
+        item.Model = model;
+    }
+
+    // sorts the items and draws them. Nothing is assumed about the GL state coming in, every
+    // bind is tracked from the first item on
+    const RenderStats& Submit()
+    {
+        stats = RenderStats();
+        sort();
+        unsigned int program = 0, vertexArray = 0;
+        unsigned int textures[2] = { 0, 0 };
+        int activeUnit = -1;
+        bool first = true, textured = false;
+        // per program, the last model matrix and instanced flag it was given
+        lastModel.resize(programs.size());
+        lastInstanced.assign(programs.size(), -1);
+        hasModel.assign(programs.size(), false);
+
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            const Item& item = items[order[i].Index];
+            const Program& target = programs[item.Program];
+            if (first || target.ID != program)
+            {
+                glUseProgram(target.ID);
+                program = target.ID;
+                stats.ProgramBinds++;
+            }
+            else
+            {
+                stats.Skipped++;
+            }
+
+            for (int unit = 0; unit < 2 && item.Material != NO_MATERIAL; unit++)
+            {
+                const Material& material = materials[item.Material];
+                if (textured && textures[unit] == material.Textures[unit])
+                {
+                    stats.Skipped++;
+                    continue;
+                }
+                if (activeUnit != unit)
+                {
+                    glActiveTexture(GL_TEXTURE0 + unit);
+                    activeUnit = unit;
+                }
+                glBindTexture(GL_TEXTURE_2D, material.Textures[unit]);
+                textures[unit] = material.Textures[unit];
+                stats.TextureBinds++;
+            }
+            textured = textured || item.Material != NO_MATERIAL;
+
+            if (first || item.VertexArray != vertexArray)
+            {
+                glBindVertexArray(item.VertexArray);
+                vertexArray = item.VertexArray;
+                stats.VertexArrayBinds++;
+            }
+            else
+            {
+                stats.Skipped++;
+            }
+
+            int instanced = item.Instances > 0 ? 1 : 0;
+            if (target.InstancedLocation >= 0)
+            {
+                if (lastInstanced[item.Program] != instanced)
+                {
+                    glUniform1i(target.InstancedLocation, instanced);
+                    lastInstanced[item.Program] = instanced;
+                    stats.UniformUploads++;
+                }
+                else
+                {
+                    stats.Skipped++;
+                }
+            }
+            if (!instanced && target.ModelLocation >= 0)
+            {
+                if (!hasModel[item.Program] || std::memcmp(&lastModel[item.Program], &item.Model, sizeof(glm::mat4)) != 0)
+                {
+                    glUniformMatrix4fv(target.ModelLocation, 1, GL_FALSE, &item.Model[0][0]);
+                    lastModel[item.Program] = item.Model;
+                    hasModel[item.Program] = true;
+                    stats.UniformUploads++;
+                }
+                else
+                {
+                    stats.Skipped++;
+                }
+            }
+
+            if (item.Indexed)
+                glDrawElements(GL_TRIANGLES, item.Count, GL_UNSIGNED_INT, 0);
+            else if (item.Instances > 0)
+                glDrawArraysInstanced(GL_TRIANGLES, 0, item.Count, item.Instances);
+            else
+                glDrawArrays(GL_TRIANGLES, 0, item.Count);
+            stats.Draws++;
+            first = false;
+        }
+        // leave the programs the way colors.vert expects them outside the queue
+        for (size_t p = 0; p < programs.size(); p++)
+        {
+            if (lastInstanced[p] == 1)
+            {
+                glUseProgram(programs[p].ID);
+                glUniform1i(programs[p].InstancedLocation, 0);
+                stats.ProgramBinds++;
+                stats.UniformUploads++;
+            }
+        }
+        glBindVertexArray(0);
+        return stats;
+    }
+
+    // what the last Submit() did
+    const RenderStats& Stats() const { return stats; }
+
+private:
+    struct Program {
+        unsigned int ID;
+        int ModelLocation;
+        int InstancedLocation;
+    };
+
+    struct Material {
+        unsigned int Textures[2];
+    };
+
+    struct Item {
+        int Program;
+        int Material;
+        unsigned int VertexArray;
+        int Count;
+        bool Indexed;
+        int Instances;
+        glm::mat4 Model;
+    };
+
+    struct SortEntry {
+        uint64_t Key;
+        uint32_t Index;
+    };
+
+    std::vector<Program> programs;
+    std::vector<Material> materials;
+    std::vector<Item> items;
+    std::vector<SortEntry> order, scratch;
+    std::vector<glm::mat4> lastModel;
+    std::vector<int> lastInstanced;
+    std::vector<bool> hasModel;
+    // index in the sort key of every vertex array added since Clear()
+    std::unordered_map<unsigned int, uint32_t> vertexArrays;
+    RenderStats stats;
+
+    Item& add(int program, int material, unsigned int vertexArray, float depth)
+    {
+        if (depth < 0.0f)
+            depth = 0.0f;
+        uint32_t depthBits;
+        std::memcpy(&depthBits, &depth, sizeof(depthBits));
+        SortEntry entry;
+        uint32_t vertexArrayIndex = vertexArrays.emplace(vertexArray, (uint32_t)vertexArrays.size()).first->second;
+        entry.Key = ((uint64_t)(program & 0xFF) << 56) | ((uint64_t)(material & 0xFFF) << 44) | ((uint64_t)(vertexArrayIndex & 0xFFF) << 32) | depthBits;
+        entry.Index = (uint32_t)items.size();
+        order.push_back(entry);
+
+        items.push_back(Item());
+        Item& item = items.back();
+        item.Program = program;
+        item.Material = material;
+        item.VertexArray = vertexArray;
+        return item;
+    }
+
+    // LSD radix sort of order by key, stable, so equal keys keep the order they were added in
+    void sort()
+    {
+        scratch.resize(order.size());
+        for (int shift = 0; shift < 64; shift += 8)
+        {
+            size_t counts[256] = { 0 };
+            for (size_t i = 0; i < order.size(); i++)
+                counts[(order[i].Key >> shift) & 0xFF]++;
+            if (order.empty() || counts[(order[0].Key >> shift) & 0xFF] == order.size())
+                continue;
+            size_t offset = 0;
+            for (int b = 0; b < 256; b++)
+            {
+                size_t count = counts[b];
+                counts[b] = offset;
+                offset += count;
+            }
+            for (size_t i = 0; i < order.size(); i++)
+                scratch[counts[(order[i].Key >> shift) & 0xFF]++] = order[i];
+            order.swap(scratch);
+        }
+    }
+};
+#endif
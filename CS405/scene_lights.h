@@ -0,0 +1,58 @@
+#ifndef SCENE_LIGHTS_H
+#define SCENE_LIGHTS_H
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+// The lights of colors.frag laid out like its Lights uniform block, std140: a vec3 takes
+// 16 bytes unless a float fills its last 4, and every struct is a multiple of 16 bytes.
+// The fields are in the order of the GLSL structs, so a SceneLights is copied to the
+// uniform buffer as it is.
+struct DirLight {
+    glm::vec3 Direction;
+    float pad0;
+    glm::vec3 Ambient;
+    float pad1;
+    glm::vec3 Diffuse;
+    float pad2;
+    glm::vec3 Specular;
+    float pad3;
+};
+
+struct PointLight {
+    glm::vec3 Position;
+    float Constant;
+    glm::vec3 Ambient;
+    float Linear;
+    glm::vec3 Diffuse;
+    float Quadratic;
+    glm::vec3 Specular;
+    float pad0;
+};
+
+struct SpotLight {
+    glm::vec3 Position;
+    float CutOff;
+    glm::vec3 Direction;
+    float OuterCutOff;
+    glm::vec3 Ambient;
+    float Constant;
+    glm::vec3 Diffuse;
+    float Linear;
+    glm::vec3 Specular;
+    float Quadratic;
+};
+
+struct SceneLights {
+    // NR_POINT_LIGHTS in colors.frag
+    enum { POINT_LIGHTS = 4 };
+
+    DirLight Dir;
+    PointLight Points[POINT_LIGHTS];
+    SpotLight Spot;
+};
+
+static_assert(sizeof(DirLight) == 64 && sizeof(PointLight) == 64 && sizeof(SpotLight) == 80, "light structs must match std140");
+static_assert(offsetof(SceneLights, Points) == 64 && offsetof(SceneLights, Spot) == 320, "SceneLights must match the Lights block");
+#endif
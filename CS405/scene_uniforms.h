@@ -0,0 +1,178 @@
+#ifndef SCENE_UNIFORMS_H
+#define SCENE_UNIFORMS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "scene_lights.h"
+#include "shader_s.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+// The uniforms every program shares, in two std140 uniform buffers on fixed binding points:
+// Camera (projection, view, viewPos) is written once per frame, Lights only where a light
+// differs from what was uploaded last, which for a scene whose lights stand still is just the
+// flashlight. A program takes part by declaring the blocks and being passed to Bind().
+class SceneUniforms
+{
+public:
+    enum {
+        CAMERA_BINDING = 0,
+        LIGHTS_BINDING = 1
+    };
+
+    // points the Camera and Lights blocks of a program at the binding points, blocks the
+    // program doesn't have are skipped
+    static void Bind(const Shader& shader)
+    {
+        shader.bindUniformBlock("Camera", CAMERA_BINDING);
+        shader.bindUniformBlock("Lights", LIGHTS_BINDING);
+    }
+
+    void SetCamera(const glm::mat4& projection, const glm::mat4& view, glm::vec3 viewPos)
+    {
+        create();
+        CameraBlock block;
+        block.Projection = projection;
+        block.View = view;
+        block.ViewPos = glm::vec4(viewPos, 1.0f);
+        glBindBuffer(GL_UNIFORM_BUFFER, cameraUBO);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(block), &block);
+    }
+
+    // uploads the lights that changed since the last call, or all of them. Neighbouring
+    // changed lights go up in one glBufferSubData(). Returns the number of bytes uploaded
+    size_t SetLights(const SceneLights& lights, bool all = false)
+    {
+        create();
+        // the block is cut at the lights, a range is uploaded if any byte in it changed
+        size_t cuts[SceneLights::POINT_LIGHTS + 3];
+        int count = 0;
+        cuts[count++] = offsetof(SceneLights, Dir);
+        for (int i = 0; i < SceneLights::POINT_LIGHTS; i++)
+            cuts[count++] = offsetof(SceneLights, Points) + i * sizeof(PointLight);
+        cuts[count++] = offsetof(SceneLights, Spot);
+        cuts[count++] = sizeof(SceneLights);
+
+        const char* next = (const char*)&lights;
+        char* last = (char*)&uploaded;
+        all = all || !lightsUploaded;
+        size_t bytes = 0;
+        size_t from = 0, to = 0;
+        glBindBuffer(GL_UNIFORM_BUFFER, lightsUBO);
+        for (int i = 0; i + 1 < count; i++)
+        {
+            size_t begin = cuts[i], end = cuts[i + 1];
+            if (!all && std::memcmp(next + begin, last + begin, end - begin) == 0)
+                continue;
+            if (to != begin)
+            {
+                bytes += flush(next, from, to);
+                from = begin;
+            }
+            to = end;
+        }
+        bytes += flush(next, from, to);
+        uploaded = lights;
+        lightsUploaded = true;
+        return bytes;
+    }
+
+    // deletes the buffers, call while the GL context is still alive
+    void Release()
+    {
+        if (cameraUBO == 0)
+            return;
+        glDeleteBuffers(1, &cameraUBO);
+        glDeleteBuffers(1, &lightsUBO);
+        cameraUBO = lightsUBO = 0;
+        lightsUploaded = false;
+    }
+
+private:
+    struct CameraBlock {
+        glm::mat4 Projection;
+        glm::mat4 View;
+        glm::vec4 ViewPos;
+    };
+
+    unsigned int cameraUBO = 0, lightsUBO = 0;
+    // what the lights buffer holds
+    SceneLights uploaded;
+    bool lightsUploaded = false;
+
+    void create()
+    {
+        if (cameraUBO != 0)
+            return;
+        glGenBuffers(1, &cameraUBO);
+        glBindBuffer(GL_UNIFORM_BUFFER, cameraUBO);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraBlock), NULL, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, CAMERA_BINDING, cameraUBO);
+        glGenBuffers(1, &lightsUBO);
+        glBindBuffer(GL_UNIFORM_BUFFER, lightsUBO);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(SceneLights), NULL, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, LIGHTS_BINDING, lightsUBO);
+    }
+
+    static size_t flush(const char* lights, size_t from, size_t to)
+    {
+        if (to <= from)
+            return 0;
+        glBufferSubData(GL_UNIFORM_BUFFER, from, to - from, lights + from);
+        return to - from;
+    }
+};
+
+// CPU time per frame of uploading the whole Lights block against uploading only the lights
+// that changed, with the flashlight following a moving camera
+inline void BenchmarkSceneUniforms(SceneUniforms& uniforms, SceneLights lights, int frames = 2000)
+{
+    auto time = [&](const char* label, bool all) {
+        size_t bytes = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < frames; i++)
+        {
+            lights.Spot.Position.x += 0.01f;
+            bytes += uniforms.SetLights(lights, all);
+        }
+        glFinish();
+        double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        std::cout << "Light uniforms " << label << ": " << seconds / frames * 1e6 << " us and " << bytes / frames << " bytes per frame" << std::endl;
+    };
+    time("whole block", true);
+    time("changed lights", false);
+}
+
+// CPU time of setting a per-draw uniform (the model matrix) three ways: looking the location
+// up in the driver every time as the set functions used to, by name through the location
+// cache of the Shader, and through a UniformHandle looked up once. The shader is left in use
+inline void BenchmarkUniformLocations(const Shader& shader, const std::string& name = "model", int sets = 100000)
+{
+    glUseProgram(shader.ID);
+    UniformHandle<glm::mat4> handle = shader.getUniform<glm::mat4>(name);
+    glm::mat4 model(1.0f);
+    auto time = [&](const char* label, int way) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < sets; i++)
+        {
+            model[3].x = (float)i;
+            if (way == 0)
+                glUniformMatrix4fv(glGetUniformLocation(shader.ID, name.c_str()), 1, GL_FALSE, &model[0][0]);
+            else if (way == 1)
+                shader.setMat4(name, model);
+            else
+                handle.set(model);
+        }
+        glFinish();
+        double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        std::cout << "Uniform " << name << " " << label << ": " << seconds / sets * 1e9 << " ns per set" << std::endl;
+    };
+    time("glGetUniformLocation", 0);
+    time("cached by name", 1);
+    time("handle", 2);
+}
+#endif
@@ -10,6 +10,30 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <unordered_map>
+
+// uploads a value to a uniform location of the program in use
+inline void setUniform(int location, bool value) { glUniform1i(location, (int)value); }
+inline void setUniform(int location, int value) { glUniform1i(location, value); }
+inline void setUniform(int location, float value) { glUniform1f(location, value); }
+inline void setUniform(int location, const glm::vec2& value) { glUniform2fv(location, 1, &value[0]); }
+inline void setUniform(int location, const glm::vec3& value) { glUniform3fv(location, 1, &value[0]); }
+inline void setUniform(int location, const glm::vec4& value) { glUniform4fv(location, 1, &value[0]); }
+inline void setUniform(int location, const glm::mat2& mat) { glUniformMatrix2fv(location, 1, GL_FALSE, &mat[0][0]); }
+inline void setUniform(int location, const glm::mat3& mat) { glUniformMatrix3fv(location, 1, GL_FALSE, &mat[0][0]); }
+inline void setUniform(int location, const glm::mat4& mat) { glUniformMatrix4fv(location, 1, GL_FALSE, &mat[0][0]); }
+
+// a uniform of one program looked up once by Shader::getUniform(), so setting it every frame
+// is a single glUniform call. Like the set functions it writes to the program in use
+template <typename T>
+struct UniformHandle
+{
+    int Location = -1;
+
+    // false if the program has no active uniform by that name, set() is a no-op then
+    bool valid() const { return Location >= 0; }
+    void set(const T& value) const { setUniform(Location, value); }
+};
 
 class Shader
 {
@@ -91,6 +115,7 @@ public:
             glAttachShader(ID, geometry);
         glLinkProgram(ID);
         checkCompileErrors(ID, "PROGRAM");
+        cacheUniforms();
         // delete the shaders as they're linked into our program now and no longer necessery
         glDeleteShader(vertex);
         glDeleteShader(fragment);
@@ -104,66 +129,126 @@ public:
     {
         glUseProgram(ID);
     }
+    // location of a uniform from the table filled at link time, -1 if the program has none
+    // by that name (the GL ignores uploads to -1, like it did for glGetUniformLocation())
+    // ------------------------------------------------------------------------
+    int getUniformLocation(const std::string& name) const
+    {
+        auto found = uniforms.find(name);
+        return found != uniforms.end() ? found->second : -1;
+    }
+    // handle for setting a uniform without looking it up by name again
+    // ------------------------------------------------------------------------
+    template <typename T>
+    UniformHandle<T> getUniform(const std::string& name) const
+    {
+        UniformHandle<T> handle;
+        handle.Location = getUniformLocation(name);
+        return handle;
+    }
+    // points a uniform block of the program at a binding point, if the program has the block
+    // ------------------------------------------------------------------------
+    void bindUniformBlock(const std::string& name, unsigned int binding) const
+    {
+        unsigned int index = glGetUniformBlockIndex(ID, name.c_str());
+        if (index != GL_INVALID_INDEX)
+            glUniformBlockBinding(ID, index, binding);
+    }
     // utility uniform functions
     // ------------------------------------------------------------------------
     void setBool(const std::string& name, bool value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+        glUniform1i(getUniformLocation(name), (int)value);
     }
     // ------------------------------------------------------------------------
     void setInt(const std::string& name, int value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+        glUniform1i(getUniformLocation(name), value);
     }
     // ------------------------------------------------------------------------
     void setFloat(const std::string& name, float value) const
     {
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+        glUniform1f(getUniformLocation(name), value);
     }
     // ------------------------------------------------------------------------
     void setVec2(const std::string& name, const glm::vec2& value) const
     {
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        glUniform2fv(getUniformLocation(name), 1, &value[0]);
     }
     void setVec2(const std::string& name, float x, float y) const
     {
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+        glUniform2f(getUniformLocation(name), x, y);
     }
     // ------------------------------------------------------------------------
     void setVec3(const std::string& name, const glm::vec3& value) const
     {
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        glUniform3fv(getUniformLocation(name), 1, &value[0]);
     }
     void setVec3(const std::string& name, float x, float y, float z) const
     {
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+        glUniform3f(getUniformLocation(name), x, y, z);
     }
     // ------------------------------------------------------------------------
     void setVec4(const std::string& name, const glm::vec4& value) const
     {
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        glUniform4fv(getUniformLocation(name), 1, &value[0]);
     }
     void setVec4(const std::string& name, float x, float y, float z, float w)
     {
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+        glUniform4f(getUniformLocation(name), x, y, z, w);
     }
     // ------------------------------------------------------------------------
     void setMat2(const std::string& name, const glm::mat2& mat) const
     {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix2fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
     void setMat3(const std::string& name, const glm::mat3& mat) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix3fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
     void setMat4(const std::string& name, const glm::mat4& mat) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
     }
 
 private:
+    // every active uniform of the program by name
+    std::unordered_map<std::string, int> uniforms;
+
+    // fills the uniform table from the linked program. Struct members and array elements are
+    // listed one by one ("pointLights[0].position"); an array of plain values is listed once
+    // as "name[0]", so its other elements and the bare name are added here
+    // ------------------------------------------------------------------------
+    void cacheUniforms()
+    {
+        uniforms.clear();
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::string buffer(maxLength > 0 ? maxLength : 1, '\0');
+        for (GLint i = 0; i < count; i++)
+        {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type;
+            glGetActiveUniform(ID, (GLuint)i, (GLsizei)buffer.size(), &length, &size, &type, &buffer[0]);
+            std::string name(buffer.data(), length);
+            int location = glGetUniformLocation(ID, name.c_str());
+            if (location < 0)
+                continue;
+            uniforms[name] = location;
+            if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+            {
+                std::string base = name.substr(0, name.size() - 3);
+                uniforms[base] = location;
+                for (GLint k = 1; k < size; k++)
+                    uniforms[base + "[" + std::to_string(k) + "]"] = glGetUniformLocation(ID, (base + "[" + std::to_string(k) + "]").c_str());
+            }
+        }
+    }
+
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
     void checkCompileErrors(GLuint shader, std::string type)